@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INCLUDED_OI_INTROSPECTIONINDEX_H
+#define INCLUDED_OI_INTROSPECTIONINDEX_H 1
+
+#include <oi/IntrospectionResult.h>
+#include <oi/result/Element.h>
+
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace oi {
+
+/*
+ * IntrospectionIndex
+ *
+ * A random-access view of the tree in an IntrospectionResult, for consumers
+ * which need more than a single pre-order walk. The index is built with one
+ * pass over the result and then answers structural queries without parsing
+ * the result again.
+ *
+ * Nodes are numbered in pre-order, so the subtree of a node is the range
+ * [id, subtree_end) and can be skipped in O(1). The children of each node are
+ * stored contiguously and can be accessed in O(1).
+ *
+ * The index refers to the names and types of the result, which must outlive
+ * it.
+ */
+class IntrospectionIndex {
+ public:
+  using NodeID = size_t;
+  static constexpr NodeID npos = std::numeric_limits<NodeID>::max();
+
+  struct Node {
+    // `type_path` is left empty, see IntrospectionIndex::typePath
+    result::Element element;
+    // Sum of the exclusive sizes of this node and all of its descendants
+    size_t inclusive_size;
+    // Offset in the result's buffer of the data read for this node
+    size_t data_offset;
+
+    NodeID parent;
+    NodeID subtree_end;
+    size_t children_begin;
+    size_t children_end;
+  };
+
+  explicit IntrospectionIndex(const IntrospectionResult& result);
+
+  size_t size() const {
+    return nodes_.size();
+  }
+  bool empty() const {
+    return nodes_.empty();
+  }
+
+  /*
+   * The root is always node 0 in a non-empty index.
+   */
+  const Node& operator[](NodeID id) const {
+    return nodes_[id];
+  }
+
+  std::span<const NodeID> children(NodeID id) const {
+    const auto& node = nodes_[id];
+    return std::span{children_}.subspan(
+        node.children_begin, node.children_end - node.children_begin);
+  }
+
+  std::vector<std::string_view> typePath(NodeID id) const;
+
+  /*
+   * Returns up to `k` children of the given node, largest inclusive size
+   * first.
+   */
+  std::vector<NodeID> largestChildren(NodeID id, size_t k) const;
+
+  /*
+   * Returns up to `k` nodes from the subtree of the given node, excluding the
+   * node itself, largest exclusive size first.
+   */
+  std::vector<NodeID> largestDescendants(NodeID id, size_t k) const;
+
+ private:
+  std::vector<Node> nodes_;
+  std::vector<NodeID> children_;
+};
+
+}  // namespace oi
+
+#endif
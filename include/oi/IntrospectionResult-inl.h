@@ -33,9 +33,26 @@ inline IntrospectionResult::IntrospectionResult(std::vector<uint8_t> buf,
     : buf_(std::move(buf)), inst_(inst) {
 }
 
+inline IntrospectionResult::IntrospectionResult(
+    std::reference_wrapper<const std::vector<uint8_t>> buf,
+    exporters::inst::Inst inst)
+    : borrowed_(&buf.get()), inst_(inst) {
+}
+
+inline const std::vector<uint8_t>& IntrospectionResult::data() const {
+  return borrowed_ != nullptr ? *borrowed_ : buf_;
+}
+
+inline void IntrospectionResult::setAggregateElements(bool aggregate) {
+  aggregate_elements_ = aggregate;
+}
+
 inline IntrospectionResult::const_iterator::const_iterator(
-    std::vector<uint8_t>::const_iterator data, exporters::inst::Inst type)
-    : data_(data), stack_({type}) {
+    std::vector<uint8_t>::const_iterator data,
+    exporters::inst::Inst type,
+    bool aggregate)
+    : data_(data), stack_(aggregate) {
+  stack_.push(type);
 }
 inline IntrospectionResult::const_iterator::const_iterator(
     std::vector<uint8_t>::const_iterator data)
@@ -45,13 +62,13 @@ inline IntrospectionResult::const_iterator IntrospectionResult::begin() const {
   return cbegin();
 }
 inline IntrospectionResult::const_iterator IntrospectionResult::cbegin() const {
-  return ++const_iterator{buf_.cbegin(), inst_};
+  return ++const_iterator{data().cbegin(), inst_, aggregate_elements_};
 }
 inline IntrospectionResult::const_iterator IntrospectionResult::end() const {
   return cend();
 }
 inline IntrospectionResult::const_iterator IntrospectionResult::cend() const {
-  return {buf_.cend()};
+  return {data().cend()};
 }
 
 inline IntrospectionResult::const_iterator
@@ -63,11 +80,12 @@ IntrospectionResult::const_iterator::operator++(int) {
 inline const result::Element& IntrospectionResult::const_iterator::operator*()
     const {
   assert(next_);
+  next_->type_path = type_path_;
   return *next_;
 }
 inline const result::Element* IntrospectionResult::const_iterator::operator->()
     const {
-  return &*next_;
+  return &operator*();
 }
 
 inline bool IntrospectionResult::const_iterator::operator==(
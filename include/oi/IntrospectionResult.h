@@ -21,18 +21,21 @@
 #include <oi/types/dy.h>
 
 #include <cstdint>
+#include <functional>
 #include <optional>
 #include <span>
-#include <stack>
 #include <string_view>
 #include <vector>
 
 namespace oi {
 
 class IntrospectionResult {
+  friend class IntrospectionIndex;
+
  public:
   class const_iterator {
     friend class IntrospectionResult;
+    friend class IntrospectionIndex;
 
    public:
     bool operator==(const const_iterator& that) const;
@@ -44,18 +47,35 @@ class IntrospectionResult {
 
    private:
     const_iterator(std::vector<uint8_t>::const_iterator data,
-                   exporters::inst::Inst type);
+                   exporters::inst::Inst type,
+                   bool aggregate);
     const_iterator(std::vector<uint8_t>::const_iterator data);
 
     std::vector<uint8_t>::const_iterator data_;
-    std::stack<exporters::inst::Inst> stack_;
-    std::optional<result::Element> next_;
+    exporters::inst::Stack stack_;
+    // `type_path` of the element is refreshed to point into this iterator's
+    // own `type_path_` when dereferenced, so copies stay valid
+    mutable std::optional<result::Element> next_;
 
     std::vector<std::string_view> type_path_;
   };
 
   IntrospectionResult(std::vector<uint8_t> buf, exporters::inst::Inst inst);
 
+  /*
+   * Borrow a caller-owned buffer instead of owning the data. The buffer must
+   * outlive this result and must not be modified while it is being read.
+   */
+  IntrospectionResult(std::reference_wrapper<const std::vector<uint8_t>> buf,
+                      exporters::inst::Inst inst);
+
+  /*
+   * Collapse each run of identical container elements which read no data
+   * (e.g. the elements of a std::vector<int>) into a single element, with
+   * `aggregate_count` set to the length of the run. Off by default.
+   */
+  void setAggregateElements(bool aggregate);
+
   const_iterator begin() const;
   const_iterator cbegin() const;
 
@@ -63,8 +83,12 @@ class IntrospectionResult {
   const_iterator cend() const;
 
  private:
+  const std::vector<uint8_t>& data() const;
+
   std::vector<uint8_t> buf_;
+  const std::vector<uint8_t>* borrowed_ = nullptr;
   exporters::inst::Inst inst_;
+  bool aggregate_elements_ = false;
 };
 
 }  // namespace oi
@@ -27,16 +27,16 @@
 #include <initializer_list>
 #include <utility>
 #include <variant>
+#include <vector>
 
 namespace oi::exporters::inst {
 
 struct PopTypePath;
 struct Field;
+class Stack;
 
 using Inst = std::variant<PopTypePath, std::reference_wrapper<const Field>>;
-using Processor = void (*)(result::Element&,
-                           std::function<void(Inst)>,
-                           ParsedData);
+using Processor = void (*)(result::Element&, Stack&, ParsedData);
 using ProcessorInst = std::pair<types::dy::Dynamic, Processor>;
 
 struct PopTypePath {};
@@ -70,6 +70,21 @@ struct Field {
   std::span<const std::string_view> type_names;
   std::span<const Field> fields;
   std::span<const ProcessorInst> processors;
+  // No processors here or in any nested field, so this field reads nothing
+  // from the data and is described entirely by its sizes.
+  bool is_static_only;
+
+ private:
+  static constexpr bool isStaticOnly(std::span<const Field> fields,
+                                     std::span<const ProcessorInst> procs) {
+    if (!procs.empty())
+      return false;
+    for (const auto& field : fields) {
+      if (!field.is_static_only)
+        return false;
+    }
+    return true;
+  }
 };
 
 template <size_t N0, size_t N1, size_t N2>
@@ -84,9 +99,61 @@ constexpr Field::Field(size_t static_size_,
       name(name_),
       type_names(type_names_),
       fields(fields_),
-      processors(processors_) {
+      processors(processors_),
+      is_static_only(isStaticOnly(fields, processors)) {
 }
 
+/*
+ * The instructions left to process while iterating over a result. Processors
+ * push the children of the element they are processing by calling it.
+ *
+ * When coalescing, consecutive pushes of the same static-only field share a
+ * single entry, which is then output as one summary element.
+ */
+class Stack {
+ public:
+  struct Entry {
+    Inst inst;
+    size_t count;
+  };
+
+  explicit Stack(bool coalesce = false) : coalesce_(coalesce) {
+  }
+
+  void operator()(Inst inst) {
+    if (coalesce_ && !entries_.empty()) {
+      using FieldRef = std::reference_wrapper<const Field>;
+      const auto* field = std::get_if<FieldRef>(&inst);
+      auto& top = entries_.back();
+      const auto* topField = std::get_if<FieldRef>(&top.inst);
+      if (field != nullptr && topField != nullptr &&
+          &field->get() == &topField->get() && field->get().is_static_only) {
+        top.count++;
+        return;
+      }
+    }
+    push(inst);
+  }
+
+  void push(Inst inst) {
+    entries_.push_back(Entry{inst, 1});
+  }
+
+  Entry pop() {
+    auto entry = entries_.back();
+    entries_.pop_back();
+    return entry;
+  }
+
+  bool empty() const {
+    return entries_.empty();
+  }
+
+ private:
+  std::vector<Entry> entries_;
+  bool coalesce_;
+};
+
 }  // namespace oi::exporters::inst
 
 #endif
@@ -21,10 +21,34 @@ static_assert(
 #endif
 #define INCLUDED_OI_OI_JIT_INL_H 1
 
+#include <exception>
 #include <stdexcept>
+#include <thread>
 
 #include "oi-jit.h"
 
+namespace oi::detail {
+
+inline BackgroundThreads::~BackgroundThreads() {
+  std::vector<std::jthread> threads;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stopping_ = true;
+    threads.swap(threads_);
+  }
+  // Joined by std::jthread's destructor, outside of the lock as the threads
+  // may be starting others.
+}
+
+template <typename F>
+inline void BackgroundThreads::start(F&& f) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (!stopping_)
+    threads_.emplace_back(std::forward<F>(f));
+}
+
+}  // namespace oi::detail
+
 namespace oi {
 
 template <typename T, Feature... Fs>
@@ -57,22 +81,98 @@ CodegenHandler<T, Fs...>::getTreeBuilderInstructions() {
 }
 
 template <typename T, Feature... Fs>
-inline bool CodegenHandler<T, Fs...>::init(const GeneratorOptions& opts) {
-  if (getIntrospectionFunc().load() != nullptr &&
-      getTreeBuilderInstructions().load() != nullptr)
-    return true;  // already initialised
-  if (getIsCritical().exchange(true))
-    return false;  // other thread is initialising/has failed
+inline std::mutex& CodegenHandler<T, Fs...>::getInitMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
 
+template <typename T, Feature... Fs>
+inline std::shared_future<bool>& CodegenHandler<T, Fs...>::getInitFuture() {
+  static std::shared_future<bool> future;
+  return future;
+}
+
+template <typename T, Feature... Fs>
+inline detail::BackgroundThreads&
+CodegenHandler<T, Fs...>::getBackgroundThreads() {
+  static detail::BackgroundThreads threads;
+  return threads;
+}
+
+template <typename T, Feature... Fs>
+inline void CodegenHandler<T, Fs...>::initImpl(const GeneratorOptions& opts) {
   auto lib =
       OILibrary(reinterpret_cast<void*>(&getIntrospectionFunc), {Fs...}, opts);
   auto [vfp, ty] = lib.init();
 
   getIntrospectionFunc().store(reinterpret_cast<func_type>(vfp));
   getTreeBuilderInstructions().store(&ty);
+
+  if (opts.backgroundOptimizationLevel.has_value())
+    tierUp(opts);
+}
+
+template <typename T, Feature... Fs>
+inline void CodegenHandler<T, Fs...>::tierUp(const GeneratorOptions& opts) {
+  auto tierUpOpts = opts;
+  tierUpOpts.optimizationLevel = opts.backgroundOptimizationLevel;
+  tierUpOpts.backgroundOptimizationLevel = std::nullopt;
+
+  // The previous function's code is never unmapped, so callers still running
+  // it are unaffected by the swap.
+  getBackgroundThreads().start([tierUpOpts = std::move(tierUpOpts)]() {
+    try {
+      initImpl(tierUpOpts);
+    } catch (...) {
+      // Keep using the function compiled by `init`
+    }
+  });
+}
+
+template <typename T, Feature... Fs>
+inline bool CodegenHandler<T, Fs...>::init(const GeneratorOptions& opts) {
+  if (getIntrospectionFunc().load() != nullptr &&
+      getTreeBuilderInstructions().load() != nullptr)
+    return true;  // already initialised
+  if (getIsCritical().exchange(true))
+    return false;  // other thread is initialising/has failed
+
+  initImpl(opts);
   return true;
 }
 
+template <typename T, Feature... Fs>
+inline std::shared_future<bool> CodegenHandler<T, Fs...>::initAsync(
+    const GeneratorOptions& opts) {
+  std::lock_guard<std::mutex> lock{getInitMutex()};
+
+  auto& future = getInitFuture();
+  if (future.valid())
+    return future;  // initAsync was already called
+
+  std::promise<bool> promise;
+  future = promise.get_future().share();
+  if (getIntrospectionFunc().load() != nullptr &&
+      getTreeBuilderInstructions().load() != nullptr) {
+    promise.set_value(true);  // already initialised
+    return future;
+  }
+  if (getIsCritical().exchange(true)) {
+    promise.set_value(false);  // blocking init is ongoing/has failed
+    return future;
+  }
+
+  getBackgroundThreads().start([opts, promise = std::move(promise)]() mutable {
+    try {
+      initImpl(opts);
+      promise.set_value(true);
+    } catch (...) {
+      promise.set_exception(std::current_exception());
+    }
+  });
+  return future;
+}
+
 template <typename T, Feature... Fs>
 inline IntrospectionResult CodegenHandler<T, Fs...>::introspect(
     const T& objectAddr) {
@@ -88,4 +188,48 @@ inline IntrospectionResult CodegenHandler<T, Fs...>::introspect(
   return IntrospectionResult{std::move(buf), *ty};
 }
 
+template <typename T, Feature... Fs>
+inline IntrospectionResult CodegenHandler<T, Fs...>::introspect(
+    const T& objectAddr, std::vector<uint8_t>& buf) {
+  func_type func = getIntrospectionFunc().load();
+  const exporters::inst::Inst* ty = getTreeBuilderInstructions().load();
+
+  if (func == nullptr || ty == nullptr)
+    throw std::logic_error("introspect(const T&) called when uninitialised");
+
+  // clear() keeps the capacity, which was sized by the previous result
+  buf.clear();
+  static_assert(sizeof(std::vector<uint8_t>) == 24);
+  func(objectAddr, buf);
+  return IntrospectionResult{std::cref(buf), *ty};
+}
+
+template <typename T, Feature... Fs>
+inline std::optional<IntrospectionResult>
+CodegenHandler<T, Fs...>::tryIntrospect(const T& objectAddr) {
+  if (getIntrospectionFunc().load() == nullptr ||
+      getTreeBuilderInstructions().load() == nullptr)
+    return std::nullopt;
+
+  return introspect(objectAddr);
+}
+
+template <typename T, Feature... Fs>
+template <typename Rep, typename Period>
+inline std::optional<IntrospectionResult> CodegenHandler<T, Fs...>::introspect(
+    const T& objectAddr, std::chrono::duration<Rep, Period> timeout) {
+  if (auto res = tryIntrospect(objectAddr))
+    return res;
+
+  std::shared_future<bool> future;
+  {
+    std::lock_guard<std::mutex> lock{getInitMutex()};
+    future = getInitFuture();
+  }
+  if (!future.valid() || future.wait_for(timeout) != std::future_status::ready)
+    return std::nullopt;
+
+  return tryIntrospect(objectAddr);
+}
+
 }  // namespace oi
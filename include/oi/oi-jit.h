@@ -17,9 +17,13 @@
 #define INCLUDED_OI_OI_JIT_H 1
 
 #include <atomic>
+#include <chrono>
 #include <filesystem>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <thread>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -29,7 +33,27 @@
 
 namespace oi::detail {
 class OILibraryImpl;
-}
+
+/*
+ * Owns the background compilation threads of a CodegenHandler. It lives in a
+ * function-local static, which is destroyed before the LLVM and glog state
+ * the threads use when the process exits: the threads are joined instead of
+ * running on under static destructors. No thread is started once it is being
+ * destroyed.
+ */
+class BackgroundThreads {
+ public:
+  ~BackgroundThreads();
+
+  template <typename F>
+  void start(F&& f);
+
+ private:
+  std::mutex mutex_;
+  bool stopping_ = false;
+  std::vector<std::jthread> threads_;
+};
+}  // namespace oi::detail
 
 namespace oi {
 
@@ -37,6 +61,30 @@ struct GeneratorOptions {
   std::filesystem::path configFilePath;
   std::filesystem::path sourceFileDumpPath;
   int debugLevel = 0;
+
+  /*
+   * Directory where compiled introspection functions are persisted, keyed by
+   * the build ID of the binary or shared library calling OIL, the
+   * introspected type, the features and the container definitions. Later
+   * runs of the same build load the object from here instead of parsing
+   * debug info and compiling again. Disabled when empty.
+   */
+  std::filesystem::path registryPath;
+
+  /*
+   * Optimisation level of the introspection function, from 0 to 3. Overrides
+   * the config file, which defaults to 3. Lower levels make `init` return
+   * sooner, at the cost of a slower `introspect`.
+   */
+  std::optional<int> optimizationLevel;
+
+  /*
+   * Tiered compilation: once `init` has compiled the introspection function
+   * at `optimizationLevel`, recompile it at this level on a background thread
+   * and swap it in when ready. Typically used with a low `optimizationLevel`
+   * to answer quickly, then introspect faster once sampling gets going.
+   */
+  std::optional<int> backgroundOptimizationLevel;
 };
 
 class OILibrary {
@@ -67,13 +115,66 @@ class CodegenHandler {
   static bool init(const GeneratorOptions& opts);
   static IntrospectionResult introspect(const T& objectAddr);
 
- private:
+  /*
+   * introspect
+   *
+   * Write the results into a caller-owned buffer, which the returned
+   * IntrospectionResult borrows. The buffer keeps its capacity from one call
+   * to the next, so reusing it across calls avoids growing a fresh vector
+   * every time.
+   */
+  static IntrospectionResult introspect(const T& objectAddr,
+                                        std::vector<uint8_t>& buf);
+
+  /*
+   * initAsync
+   *
+   * Run JIT compilation on a background thread and return immediately. The
+   * future becomes true once `introspect` can be called, or holds the
+   * exception that made initialisation fail. Later calls return the same
+   * future. It is immediately false if a blocking `init` is ongoing or has
+   * failed.
+   */
+  static std::shared_future<bool> initAsync(const GeneratorOptions& opts);
+
+  /*
+   * tryIntrospect
+   *
+   * Introspect the given object if initialisation has completed, without
+   * ever waiting for it. Returns std::nullopt otherwise.
+   */
+  static std::optional<IntrospectionResult> tryIntrospect(const T& objectAddr);
+
+  /*
+   * introspect
+   *
+   * Wait up to `timeout` for an ongoing `initAsync` to complete, then
+   * introspect the given object. Returns std::nullopt if initialisation is
+   * still pending after the timeout, has failed or was never started.
+   */
+  template <typename Rep, typename Period>
+  static std::optional<IntrospectionResult> introspect(
+      const T& objectAddr, std::chrono::duration<Rep, Period> timeout);
+
+ protected:
   using func_type = void (*)(const T&, std::vector<uint8_t>&);
 
-  static std::atomic<bool>& getIsCritical();
+  /*
+   * The current introspection function, which tier-up replaces. Protected so
+   * tests can observe the swap.
+   */
   static std::atomic<func_type>& getIntrospectionFunc();
+
+ private:
+  static void initImpl(const GeneratorOptions& opts);
+  static void tierUp(const GeneratorOptions& opts);
+
+  static std::atomic<bool>& getIsCritical();
   static std::atomic<const exporters::inst::Inst*>&
   getTreeBuilderInstructions();
+  static std::mutex& getInitMutex();
+  static std::shared_future<bool>& getInitFuture();
+  static detail::BackgroundThreads& getBackgroundThreads();
 };
 
 }  // namespace oi
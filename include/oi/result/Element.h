@@ -19,7 +19,6 @@
 #include <optional>
 #include <span>
 #include <string_view>
-#include <vector>
 
 namespace oi::result {
 
@@ -33,8 +32,8 @@ struct Element {
   };
 
   std::string_view name;
-  std::vector<std::string_view>
-      type_path;  // TODO: should be span<const std::string_view>
+  // Only valid until the iterator which produced this element is advanced
+  std::span<const std::string_view> type_path;
   std::span<const std::string_view> type_names;
   size_t static_size;
   size_t exclusive_size;
@@ -42,6 +41,11 @@ struct Element {
   std::optional<uintptr_t> pointer;
   std::optional<ContainerStats> container_stats;
   std::optional<IsSetStats> is_set_stats;
+
+  // Set when this element summarises a run of identical container elements,
+  // see IntrospectionResult::setAggregateElements. The sizes above are then
+  // the total over all of these elements.
+  std::optional<size_t> aggregate_count;
 };
 
 }  // namespace oi::result
@@ -29,6 +29,14 @@
  * which describes where to write data, and has no other fields. DataBuffers
  * should remain pointer sized enabling trivial copies.
  *
+ * DataBuffers may also provide two optional methods for bulk writes:
+ * `void write_bytes(const uint8_t*, size_t)`, which writes several bytes at
+ * once; and, `void reserve(size_t)`, which hints that at most this many more
+ * bytes are about to be written. Static Types use them when available.
+ *
+ * Each Static Type also exposes `maxSize`, an upper bound on the number of
+ * bytes it writes, or `unboundedSize` if there is none (e.g. Lists).
+ *
  * Writing to an object of a given static type returns a different type which
  * has had that part written. When there is no more to write, the type will
  * return a Unit. There are two ways to write data from the JIT code into a
@@ -55,12 +63,38 @@
  * dynamic description of their type as the constexpr field `describe`. Compound
  * types compose appropriately.
  */
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
 namespace oi::types::st {
 
 #ifdef DEFINE_DESCRIBE
 #include "oi/types/dy.h"
 #endif
 
+constexpr size_t unboundedSize = static_cast<size_t>(-1);
+
+namespace detail {
+
+constexpr size_t addMaxSize(size_t a, size_t b) {
+  if (a == unboundedSize || b == unboundedSize || a > unboundedSize - b)
+    return unboundedSize;
+  return a + b;
+}
+
+template <typename DataBuffer>
+concept BulkWritable = requires(DataBuffer db, const uint8_t* p, size_t n) {
+  db.write_bytes(p, n);
+};
+
+template <typename DataBuffer>
+concept Reservable = requires(DataBuffer db, size_t n) {
+  db.reserve(n);
+};
+
+}  // namespace detail
+
 /*
  * Unit
  *
@@ -84,6 +118,8 @@ class Unit {
     return cb(*this);
   }
 
+  static constexpr size_t maxSize = 0;
+
 #ifdef DEFINE_DESCRIBE
   static constexpr types::dy::Unit describe{};
 #endif
@@ -122,12 +158,26 @@ class VarInt {
   VarInt(DataBuffer db) : _buf(db) {
   }
 
+  static constexpr size_t maxSize = 10;
+
   Unit<DataBuffer> write(uint64_t val) {
-    while (val >= 0x80) {
-      _buf.write_byte(0x80 | (val & 0x7f));
-      val >>= 7;
+    if constexpr (detail::BulkWritable<DataBuffer>) {
+      // Encode on the stack and hand the DataBuffer a single write
+      uint8_t bytes[maxSize];
+      size_t n = 0;
+      while (val >= 0x80) {
+        bytes[n++] = 0x80 | (val & 0x7f);
+        val >>= 7;
+      }
+      bytes[n++] = uint8_t(val);
+      _buf.write_bytes(bytes, n);
+    } else {
+      while (val >= 0x80) {
+        _buf.write_byte(0x80 | (val & 0x7f));
+        val >>= 7;
+      }
+      _buf.write_byte(uint8_t(val));
     }
-    _buf.write_byte(uint8_t(val));
     return Unit<DataBuffer>(_buf);
   }
 
@@ -175,6 +225,9 @@ class Pair {
     return cb(*this);
   }
 
+  static constexpr size_t maxSize =
+      detail::addMaxSize(T1::maxSize, T2::maxSize);
+
 #ifdef DEFINE_DESCRIBE
   static constexpr types::dy::Pair describe{T1::describe, T2::describe};
 #endif
@@ -232,6 +285,9 @@ class Sum {
     return cb(*this);
   }
 
+  static constexpr size_t maxSize = detail::addMaxSize(
+      VarInt<DataBuffer>::maxSize, std::max({size_t{0}, Types::maxSize...}));
+
 #ifdef DEFINE_DESCRIBE
  private:
   static constexpr std::array<types::dy::Dynamic, sizeof...(Types)> members{
@@ -268,6 +324,21 @@ class ListContents {
     return {_buf};
   }
 
+  static constexpr size_t maxSize = unboundedSize;
+
+  /*
+   * Let the DataBuffer make room for `length` elements in one go, when the
+   * size of an element is bounded.
+   */
+  ListContents<DataBuffer, T> reserve(size_t length) {
+    if constexpr (detail::Reservable<DataBuffer> && T::maxSize > 0 &&
+                  T::maxSize != unboundedSize) {
+      if (length <= unboundedSize / T::maxSize)
+        _buf.reserve(length * T::maxSize);
+    }
+    return *this;
+  }
+
  private:
   DataBuffer _buf;
 };
@@ -289,6 +360,12 @@ class List
       : Pair<DataBuffer, VarInt<DataBuffer>, ListContents<DataBuffer, T>>(db) {
   }
 
+  ListContents<DataBuffer, T> write(uint64_t length) {
+    using Base =
+        Pair<DataBuffer, VarInt<DataBuffer>, ListContents<DataBuffer, T>>;
+    return Base::write(length).reserve(length);
+  }
+
   template <typename F>
   Unit<DataBuffer> consume(F const& cb) {
     return cb(*this);
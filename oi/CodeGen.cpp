@@ -25,6 +25,7 @@
 
 #include "oi/FuncGen.h"
 #include "oi/Headers.h"
+#include "oi/OICompiler.h"
 #include "oi/SymbolService.h"
 #include "type_graph/AddChildren.h"
 #include "type_graph/AddPadding.h"
@@ -147,9 +148,11 @@ void __jlogptr(uintptr_t ptr) {
   }
 }
 
-void addIncludes(const TypeGraph& typeGraph,
-                 FeatureSet features,
-                 std::string& code) {
+/*
+ * Includes that only depend on the enabled features. They are part of the
+ * prelude shared by all the generated code, see OICompiler::preludeEnd.
+ */
+void addFeatureIncludes(FeatureSet features, std::string& code) {
   std::set<std::string_view> includes{"cstddef"};
   if (features[Feature::TypedDataSegment]) {
     includes.emplace("functional");
@@ -169,6 +172,15 @@ void addIncludes(const TypeGraph& typeGraph,
   if (features[Feature::JitTiming]) {
     includes.emplace("chrono");
   }
+  for (const auto& include : includes) {
+    code += "#include <";
+    code += include;
+    code += ">\n";
+  }
+}
+
+void addContainerIncludes(const TypeGraph& typeGraph, std::string& code) {
+  std::set<std::string_view> includes;
   for (const Type& t : typeGraph.finalTypes) {
     if (const auto* c = dynamic_cast<const Container*>(&t)) {
       includes.emplace(c->containerInfo_.header);
@@ -947,9 +959,7 @@ void genContainerTypeHandler(FeatureSet features,
   for (const auto& pr : processors) {
     code += "  static void processor_";
     code += std::to_string(count++);
-    code +=
-        "(result::Element& el, std::function<void(inst::Inst)> stack_ins, "
-        "ParsedData d) {\n";
+    code += "(result::Element& el, inst::Stack& stack_ins, ParsedData d) {\n";
     code += pr.func;  // bad indentation
     code += "  }\n";
   }
@@ -1134,7 +1144,10 @@ void CodeGen::generate(
   if (!config_.features[Feature::TypedDataSegment]) {
     defineMacros(code);
   }
-  addIncludes(typeGraph, config_.features, code);
+  addFeatureIncludes(config_.features, code);
+  code += OICompiler::preludeEnd;
+
+  addContainerIncludes(typeGraph, code);
   defineArray(code);
   defineJitLog(config_.features, code);
 
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <stdexcept>
+
+namespace oi::detail {
+
+/*
+ * DataSegmentCursor
+ *
+ * Reads the values written by the JIT code one at a time. The cursor works
+ * either straight over the raw varint-encoded bytes of a data segment, in
+ * which case values are only decoded when they are requested, or over values
+ * that have already been decoded (e.g. loaded from a data-segment dump).
+ *
+ * The JIT code terminates its output with the sentinel value 123456789:
+ *  - a single sentinel indicates the end of results for the current object
+ *    and is skipped,
+ *  - two consecutive sentinels indicate we have finished completely.
+ */
+class DataSegmentCursor {
+ public:
+  static constexpr uint64_t sentinel = 123456789;
+
+  explicit DataSegmentCursor(std::span<const uint8_t> encoded)
+      : encoded_{encoded} {
+  }
+
+  explicit DataSegmentCursor(std::span<const uint64_t> decoded)
+      : decoded_{decoded}, isDecoded_{true} {
+  }
+
+  /*
+   * Returns the next value, or std::nullopt once the end of the data has been
+   * reached. Throws if the varint stream is malformed.
+   */
+  std::optional<uint64_t> next() {
+    if (isDecoded_) {
+      if (decodedIndex_ >= decoded_.size()) {
+        return std::nullopt;
+      }
+      consumed_++;
+      return decoded_[decodedIndex_++];
+    }
+
+    while (!finished_) {
+      uint64_t val = decodeVarint();
+      if (val == sentinel) {
+        finished_ = prevSentinel_;
+        prevSentinel_ = true;
+        continue;
+      }
+
+      prevSentinel_ = false;
+      consumed_++;
+      return val;
+    }
+
+    return std::nullopt;
+  }
+
+  /*
+   * Number of values returned by `next()` so far.
+   */
+  size_t consumed() const {
+    return consumed_;
+  }
+
+ private:
+  uint64_t decodeVarint() {
+    constexpr size_t maxVarintBytes = 10;
+
+    uint64_t val = 0;
+    for (size_t shift = 0, i = 0; i < maxVarintBytes; shift += 7, i++) {
+      if (encodedOffset_ >= encoded_.size()) {
+        throw std::runtime_error("Invalid varint value: too few bytes.");
+      }
+
+      uint8_t byte = encoded_[encodedOffset_++];
+      val |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return val;
+      }
+    }
+
+    throw std::runtime_error("Invalid varint value: too many bytes.");
+  }
+
+  std::span<const uint8_t> encoded_{};
+  size_t encodedOffset_ = 0;
+  bool prevSentinel_ = false;
+  bool finished_ = false;
+
+  std::span<const uint64_t> decoded_{};
+  size_t decodedIndex_ = 0;
+  bool isDecoded_ = false;
+
+  size_t consumed_ = 0;
+};
+
+}  // namespace oi::detail
@@ -153,6 +153,7 @@ void FuncGen::DeclareExterns(std::string& code) {
 extern uint8_t* dataBase;
 extern size_t dataSize;
 extern uintptr_t cookieValue;
+extern size_t pointersSize;
   )";
   code.append(vars);
 }
@@ -267,6 +268,7 @@ void __attribute__((used, retain)) introspect_%2$016x(
 
   ContentType ret{DataBufferType{v}};
   OIInternal::getSizeType<DataBufferType>(t, ret);
+  pointers.release();
 }
 )";
 
@@ -311,7 +313,7 @@ void FuncGen::DefineTopLevelGetSizeRef(std::string& testCode,
     func += "      const auto startTime = std::chrono::steady_clock::now();\n";
   }
   func += R"(
-      pointers.initialize();
+      pointers.initialize(pointersSize);
       pointers.add((uintptr_t)&t);
       auto data = reinterpret_cast<uintptr_t*>(dataBase);
 
@@ -321,6 +323,8 @@ void FuncGen::DefineTopLevelGetSizeRef(std::string& testCode,
       uintptr_t& writtenSize = data[dataSegOffset++];
       writtenSize = 0;
       uintptr_t& timeTakenNs = data[dataSegOffset++];
+      auto& pointerStats = reinterpret_cast<PointerSetStats&>(data[dataSegOffset]);
+      dataSegOffset += sizeof(PointerSetStats) / sizeof(uintptr_t);
 
       dataSegOffset *= sizeof(uintptr_t);
       JLOG("%1% @");
@@ -330,6 +334,8 @@ void FuncGen::DefineTopLevelGetSizeRef(std::string& testCode,
       OIInternal::StoreData((uintptr_t)123456789, dataSegOffset);
       writtenSize = dataSegOffset;
       dataBase += dataSegOffset;
+      pointerStats = pointers.stats();
+      pointers.release();
     )";
   if (features[Feature::JitTiming]) {
     func += R"(
@@ -367,7 +373,7 @@ void FuncGen::DefineTopLevelGetSizeRefTyped(std::string& testCode,
     func += "      const auto startTime = std::chrono::steady_clock::now();\n";
   }
   func += R"(
-      pointers.initialize();
+      pointers.initialize(pointersSize);
       pointers.add((uintptr_t)&t);
       auto data = reinterpret_cast<uintptr_t*>(dataBase);
 
@@ -379,6 +385,8 @@ void FuncGen::DefineTopLevelGetSizeRefTyped(std::string& testCode,
       uintptr_t& writtenSize = data[dataSegOffset++];
       writtenSize = 0;
       uintptr_t& timeTakenNs = data[dataSegOffset++];
+      auto& pointerStats = reinterpret_cast<PointerSetStats&>(data[dataSegOffset]);
+      dataSegOffset += sizeof(PointerSetStats) / sizeof(uintptr_t);
 
       dataSegOffset *= sizeof(uintptr_t);
       JLOG("%1% @");
@@ -407,6 +415,8 @@ void FuncGen::DefineTopLevelGetSizeRefTyped(std::string& testCode,
       dataSegOffset = end.offset();
       writtenSize = dataSegOffset;
       dataBase += dataSegOffset;
+      pointerStats = pointers.stats();
+      pointers.release();
     )";
   if (features[Feature::JitTiming]) {
     func += R"(
@@ -499,6 +509,7 @@ void FuncGen::DefineTopLevelGetSizeRefRet(std::string& testCode,
       size_t ret = 0;
       pointers.add((uintptr_t)&t);
       OIInternal::getSizeType(t, ret);
+      pointers.release();
       return ret;
     }
     )";
@@ -522,7 +533,7 @@ void FuncGen::DefineTopLevelGetSizeSmartPtr(std::string& testCode,
     func += "      const auto startTime = std::chrono::steady_clock::now();\n";
   }
   func += R"(
-      pointers.initialize();
+      pointers.initialize(pointersSize);
       auto data = reinterpret_cast<uintptr_t*>(dataBase);
 
       size_t dataSegOffset = 0;
@@ -531,6 +542,8 @@ void FuncGen::DefineTopLevelGetSizeSmartPtr(std::string& testCode,
       uintptr_t& writtenSize = data[dataSegOffset++];
       writtenSize = 0;
       uintptr_t& timeTakenNs = data[dataSegOffset++];
+      auto& pointerStats = reinterpret_cast<PointerSetStats&>(data[dataSegOffset]);
+      dataSegOffset += sizeof(PointerSetStats) / sizeof(uintptr_t);
 
       dataSegOffset *= sizeof(uintptr_t);
 
@@ -539,6 +552,8 @@ void FuncGen::DefineTopLevelGetSizeSmartPtr(std::string& testCode,
       OIInternal::StoreData((uintptr_t)123456789, dataSegOffset);
       writtenSize = dataSegOffset;
       dataBase += dataSegOffset;
+      pointerStats = pointers.stats();
+      pointers.release();
     )";
   if (features[Feature::JitTiming]) {
     func += R"(
@@ -654,6 +669,15 @@ void FuncGen::DefineDataSegmentDataBuffer(std::string& testCode) {
           buf++;
         }
 
+        void write_bytes(const uint8_t* bytes, size_t n) {
+          uint8_t* end = dataBase + dataSize;
+          if (buf < end) {
+            size_t avail = end - buf;
+            __builtin_memcpy(buf, bytes, n < avail ? n : avail);
+          }
+          buf += n;
+        }
+
         size_t offset() {
           return buf - dataBase;
         }
@@ -671,8 +695,8 @@ void FuncGen::DefineDataSegmentDataBuffer(std::string& testCode) {
 /*
  * DefineBackInserterDataBuffer
  *
- * Provides a DataBuffer implementation that takes anything convertible with
- * std::back_inserter.
+ * Provides a DataBuffer implementation that appends to any container with
+ * push_back, insert and reserve, like std::vector.
  */
 void FuncGen::DefineBackInserterDataBuffer(std::string& code) {
   constexpr std::string_view buf = R"(
@@ -681,13 +705,25 @@ namespace oi::detail::DataBuffer {
 template <class Container>
 class BackInserter {
  public:
-  BackInserter(Container& v) : buf(v) {}
+  BackInserter(Container& v) : buf(&v) {}
 
   void write_byte(uint8_t byte) {
-    *buf = byte;
+    buf->push_back(byte);
+  }
+
+  void write_bytes(const uint8_t* bytes, size_t n) {
+    buf->insert(buf->end(), bytes, bytes + n);
+  }
+
+  void reserve(size_t n) {
+    // Keep growing geometrically, nested lists reserve many times
+    size_t needed = buf->size() + n;
+    size_t doubled = 2 * buf->capacity();
+    if (needed > buf->capacity())
+      buf->reserve(needed > doubled ? needed : doubled);
   }
  private:
-  std::back_insert_iterator<Container> buf;
+  Container* buf;
 };
 
 } // namespace oi::detail::DataBuffer
@@ -726,10 +762,10 @@ void FuncGen::DefineBasicTypeHandlers(std::string& code, FeatureSet features) {
 )";
   if (features[Feature::TreeBuilderV2]) {
     code += R"(private:
-        static void process_pointer(result::Element& el, std::function<void(inst::Inst)> stack_ins, ParsedData d) {
+        static void process_pointer(result::Element& el, inst::Stack& stack_ins, ParsedData d) {
           el.pointer = std::get<ParsedData::VarInt>(d.val).value;
         }
-        static void process_pointer_content(result::Element& el, std::function<void(inst::Inst)> stack_ins, ParsedData d) {
+        static void process_pointer_content(result::Element& el, inst::Stack& stack_ins, ParsedData d) {
           static constexpr std::array<std::string_view, 1> names{"TODO"};
           static constexpr auto childField = inst::Field{
             sizeof(T),
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <oi/IntrospectionIndex.h>
+
+#include <algorithm>
+#include <ranges>
+
+namespace oi {
+
+namespace {
+
+/*
+ * The `k` IDs with the largest sizes, largest first. Keeps a heap of at most
+ * `k` IDs, so large subtrees can be searched without copying them.
+ */
+template <typename IDs, typename SizeFn>
+std::vector<IntrospectionIndex::NodeID> largest(IDs&& ids,
+                                                size_t k,
+                                                SizeFn size) {
+  auto larger = [&size](auto a, auto b) { return size(a) > size(b); };
+
+  std::vector<IntrospectionIndex::NodeID> heap;
+  if (k == 0)
+    return heap;
+
+  for (auto id : ids) {
+    if (heap.size() < k) {
+      heap.push_back(id);
+      std::push_heap(heap.begin(), heap.end(), larger);
+    } else if (size(id) > size(heap.front())) {
+      std::pop_heap(heap.begin(), heap.end(), larger);
+      heap.back() = id;
+      std::push_heap(heap.begin(), heap.end(), larger);
+    }
+  }
+  std::sort_heap(heap.begin(), heap.end(), larger);
+  return heap;
+}
+
+}  // namespace
+
+IntrospectionIndex::IntrospectionIndex(const IntrospectionResult& result) {
+  const auto dataBegin = result.data().cbegin();
+  size_t dataOffset = 0;
+
+  // The most recent node at each depth of the tree
+  std::vector<NodeID> open;
+  for (auto it = result.cbegin(); it != result.cend(); ++it) {
+    auto id = nodes_.size();
+    auto depth = it->type_path.size();
+    auto parent = depth > 1 ? open[depth - 2] : npos;
+    open.resize(depth);
+    open[depth - 1] = id;
+
+    auto& node = nodes_.emplace_back(Node{
+        .element = *it,
+        .inclusive_size = 0,
+        .data_offset = dataOffset,
+        .parent = parent,
+        .subtree_end = id + 1,
+        .children_begin = 0,
+        .children_end = 0,
+    });
+    node.element.type_path = {};
+
+    // The iterator has consumed this node's data, the next node's starts here
+    dataOffset = static_cast<size_t>(it.data_ - dataBegin);
+  }
+
+  // Children have higher IDs than their parent, so a reverse pass sees every
+  // subtree before the node that contains it.
+  std::vector<size_t> childCounts(nodes_.size());
+  for (auto id = nodes_.size(); id-- > 0;) {
+    auto& node = nodes_[id];
+    node.inclusive_size += node.element.exclusive_size;
+    if (node.parent == npos)
+      continue;
+
+    auto& parent = nodes_[node.parent];
+    parent.inclusive_size += node.inclusive_size;
+    parent.subtree_end = std::max(parent.subtree_end, node.subtree_end);
+    childCounts[node.parent]++;
+  }
+
+  // Lay out the children of each node contiguously, in pre-order
+  size_t offset = 0;
+  for (NodeID id = 0; id < nodes_.size(); id++) {
+    nodes_[id].children_begin = nodes_[id].children_end = offset;
+    offset += childCounts[id];
+  }
+  children_.resize(offset);
+  for (NodeID id = 0; id < nodes_.size(); id++) {
+    if (auto parent = nodes_[id].parent; parent != npos)
+      children_[nodes_[parent].children_end++] = id;
+  }
+}
+
+std::vector<std::string_view> IntrospectionIndex::typePath(NodeID id) const {
+  std::vector<std::string_view> path;
+  for (; id != npos; id = nodes_[id].parent)
+    path.push_back(nodes_[id].element.name);
+  std::reverse(path.begin(), path.end());
+  return path;
+}
+
+std::vector<IntrospectionIndex::NodeID> IntrospectionIndex::largestChildren(
+    NodeID id, size_t k) const {
+  return largest(children(id), k,
+                 [this](NodeID n) { return nodes_[n].inclusive_size; });
+}
+
+std::vector<IntrospectionIndex::NodeID> IntrospectionIndex::largestDescendants(
+    NodeID id, size_t k) const {
+  return largest(std::views::iota(id + 1, nodes_[id].subtree_end), k,
+                 [this](NodeID n) { return nodes_[n].element.exclusive_size; });
+}
+
+}  // namespace oi
@@ -33,40 +33,49 @@ IntrospectionResult::const_iterator::operator++() {
     return *this;
   }
 
-  auto el = stack_.top();
-  stack_.pop();
+  auto entry = stack_.pop();
+  auto count = entry.count;
 
   return std::visit(
-      [this](auto&& r) -> IntrospectionResult::const_iterator& {
+      [this, count](auto&& r) -> IntrospectionResult::const_iterator& {
         using U = std::decay_t<decltype(r)>;
         if constexpr (std::is_same_v<U, exporters::inst::PopTypePath>) {
           type_path_.pop_back();
           return operator++();
         } else {
           // reference wrapper
-          auto ty = r.get();
+          const auto& ty = r.get();
           using T = std::decay_t<decltype(ty)>;
 
           if constexpr (std::is_same_v<T, exporters::inst::Field>) {
             type_path_.emplace_back(ty.name);
-            stack_.emplace(exporters::inst::PopTypePath{});
+            stack_.push(exporters::inst::PopTypePath{});
             next_ = result::Element{
                 .name = ty.name,
                 .type_path = type_path_,
                 .type_names = ty.type_names,
-                .static_size = ty.static_size,
-                .exclusive_size = ty.exclusive_size,
+                .static_size = ty.static_size * count,
+                .exclusive_size = ty.exclusive_size * count,
+                .pointer = std::nullopt,
                 .container_stats = std::nullopt,
                 .is_set_stats = std::nullopt,
+                .aggregate_count = std::nullopt,
             };
 
+            if (count > 1) {
+              // A summary of static-only elements: there is nothing to parse
+              // and the nested fields are accounted for in the sizes.
+              next_->exclusive_size = next_->static_size;
+              next_->aggregate_count = count;
+              return *this;
+            }
+
             for (const auto& [dy, handler] : ty.processors) {
               auto parsed = exporters::ParsedData::parse(data_, dy);
-              handler(
-                  *next_, [this](auto i) { stack_.emplace(i); }, parsed);
+              handler(*next_, stack_, parsed);
             }
             for (auto it = ty.fields.rbegin(); it != ty.fields.rend(); ++it) {
-              stack_.emplace(*it);
+              stack_.push(*it);
             }
 
             return *this;
@@ -75,7 +84,7 @@ IntrospectionResult::const_iterator::operator++() {
           }
         }
       },
-      el);
+      entry.inst);
 }
 
 }  // namespace oi
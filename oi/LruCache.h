@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace oi::detail {
+
+/*
+ * LruCache
+ *
+ * Map holding at most `capacity` entries. Looking up or inserting an entry
+ * makes it the most recently used one; inserting into a full cache evicts the
+ * least recently used entry. Callers with a memory budget rather than an
+ * entry budget can also evict entries themselves with `evictOldest`.
+ */
+template <typename Key, typename Value>
+class LruCache {
+ public:
+  explicit LruCache(size_t capacity) : capacity_{capacity} {
+  }
+
+  /*
+   * Returns the entry for `key`, or nullptr if there is none. The pointer is
+   * valid until the entry is evicted.
+   */
+  Value* get(const Key& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return nullptr;
+    }
+
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->second;
+  }
+
+  /*
+   * Insert or replace the entry for `key`, evicting the least recently used
+   * entries if the cache is over capacity.
+   */
+  Value& put(const Key& key, Value value) {
+    if (auto* existing = get(key)) {
+      *existing = std::move(value);
+      return *existing;
+    }
+
+    entries_.emplace_front(key, std::move(value));
+    index_.emplace(key, entries_.begin());
+    while (entries_.size() > capacity_ && entries_.size() > 1) {
+      evictOldest();
+    }
+    return entries_.front().second;
+  }
+
+  /*
+   * Evict the least recently used entry. Returns false if the cache is empty.
+   */
+  bool evictOldest() {
+    if (entries_.empty()) {
+      return false;
+    }
+
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+    return true;
+  }
+
+  size_t size() const {
+    return entries_.size();
+  }
+
+ private:
+  using Entries = std::list<std::pair<Key, Value>>;
+
+  size_t capacity_;
+  Entries entries_;
+  std::unordered_map<Key, typename Entries::iterator> index_;
+};
+
+}  // namespace oi::detail
@@ -134,6 +134,15 @@ void Tracing::stop() {
                             duration.count(), rssBeforeBytes, rssAfterBytes});
 }
 
+void Tracing::incrementCounter(const std::string& name, uint64_t value) {
+  if (!static_.traceEnabled) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> guard{static_.mutex};
+  static_.counters[name] += value;
+}
+
 void Tracing::saveTraces(const std::filesystem::path& output) {
   std::ofstream osf{output};
   if (!osf) {
@@ -162,6 +171,32 @@ void Tracing::saveTraces(const std::filesystem::path& output) {
     osf << "}";
   }
   osf << "]\n";
+
+  saveCounters(countersPath(output));
+}
+
+std::filesystem::path Tracing::countersPath(std::filesystem::path output) {
+  return output.replace_extension(".counters.json");
+}
+
+void Tracing::saveCounters(const std::filesystem::path& output) {
+  std::ofstream osf{output};
+  if (!osf) {
+    perror("Failed to open counters output file");
+    return;
+  }
+
+  osf << "{";
+  bool first = true;
+  for (const auto& [name, count] : static_.counters) {
+    if (!first) {
+      osf << ",";
+    }
+    first = false;
+
+    osf << "\"" << name << "\":" << count;
+  }
+  osf << "}\n";
 }
 
 const char* Tracing::outputPath() {
@@ -16,7 +16,9 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 #include <filesystem>
+#include <map>
 #include <mutex>
 #include <ostream>
 #include <string>
@@ -33,7 +35,7 @@ constexpr auto outputEnvKey = "OID_METRICS_OUTPUT";
  * By default, no metrics are collected.
  * The metrics are written to the path specified by the environment variable
  * OID_METRICS_OUTPUT. If not specified, they are written into
- * "oid_metrics.json".
+ * "oid_metrics.json", and the counters into "oid_metrics.counters.json".
  */
 struct TraceFlags {
   bool time = false;
@@ -65,6 +67,7 @@ class Tracing final {
     long pageSizeKB;
     TraceFlags traceEnabled;
     std::vector<Span> traces;
+    std::map<std::string, uint64_t> counters;
     std::mutex mutex;
 
     Static();
@@ -152,13 +155,21 @@ class Tracing final {
   static TraceFlags& isEnabled() {
     return static_.traceEnabled;
   }
+  /*
+   * Counters track how often something happened (e.g. cache hits) rather
+   * than how long it took. They are saved next to the spans, in the file
+   * given by `countersPath`, as a JSON object of name to count.
+   */
+  static void incrementCounter(const std::string& name, uint64_t value = 1);
   static const char* outputPath();
+  static std::filesystem::path countersPath(std::filesystem::path output);
   static void saveTraces(const std::filesystem::path&);
 
  private:
   static uint32_t getNextIndex();
   static TimePoint fetchTime();
   static long fetchRssUsage();
+  static void saveCounters(const std::filesystem::path&);
 
   bool ended{false};
   std::string traceName{};
@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "oi/NodeFile.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+extern "C" {
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+}
+
+namespace oi::detail::nodefile {
+
+namespace {
+
+[[noreturn]] void throwErrno(const std::string& what) {
+  throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+uint64_t alignUp(uint64_t offset, uint64_t align) {
+  return (offset + align - 1) / align * align;
+}
+
+uint64_t recordOffset(uint64_t index) {
+  return sizeof(NodeFileHeader) + index * sizeof(NodeRecord);
+}
+
+}  // namespace
+
+NodeFileWriter::NodeFileWriter(const std::filesystem::path& path,
+                               NodeID firstNodeID_)
+    : firstNodeID{firstNodeID_} {
+  fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd == -1) {
+    throwErrno("Failed to open node file '" + path.string() + "'");
+  }
+
+  // Reserve the header, it is written by `finish`
+  NodeFileHeader header{};
+  pwriteAll(&header, sizeof(header), 0);
+}
+
+NodeFileWriter::~NodeFileWriter() {
+  if (fd != -1) {
+    close(fd);
+  }
+}
+
+void NodeFileWriter::pwriteAll(const void* buf,
+                               size_t size,
+                               uint64_t offset) const {
+  const auto* bytes = static_cast<const char*>(buf);
+  while (size > 0) {
+    auto written = pwrite(fd, bytes, size, static_cast<off_t>(offset));
+    if (written == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throwErrno("Failed to write node file");
+    }
+
+    bytes += written;
+    size -= static_cast<size_t>(written);
+    offset += static_cast<uint64_t>(written);
+  }
+}
+
+StringRef NodeFileWriter::addString(std::string_view str) {
+  if (str.empty()) {
+    return StringRef{0, 0};
+  }
+
+  auto [it, inserted] = stringIndex.try_emplace(std::string{str});
+  if (inserted) {
+    it->second = StringRef{stringTable.size(), str.size()};
+    stringTable.append(str);
+  }
+  return it->second;
+}
+
+void NodeFileWriter::write(const NodeRecord& record) {
+  if (record.id < firstNodeID) {
+    throw std::runtime_error("Invalid node ID for node file: " +
+                             std::to_string(record.id));
+  }
+
+  uint64_t index = record.id - firstNodeID;
+  NodeRecord toWrite = record;
+  toWrite.flags |= NodeRecord::Written;
+  pwriteAll(&toWrite, sizeof(toWrite), recordOffset(index));
+
+  nodeCount = std::max(nodeCount, index + 1);
+}
+
+NodeRecord NodeFileWriter::read(NodeID id) const {
+  NodeRecord record{};
+  if (id < firstNodeID || id - firstNodeID >= nodeCount) {
+    throw std::runtime_error("Node file has no node [" + std::to_string(id) +
+                             "]");
+  }
+
+  auto offset = static_cast<off_t>(recordOffset(id - firstNodeID));
+  if (pread(fd, &record, sizeof(record), offset) !=
+      static_cast<ssize_t>(sizeof(record))) {
+    throwErrno("Failed to read node [" + std::to_string(id) + "]");
+  }
+
+  if (!record.has(NodeRecord::Written)) {
+    throw std::runtime_error("Node file has no node [" + std::to_string(id) +
+                             "]");
+  }
+  return record;
+}
+
+std::string_view NodeFileWriter::getString(StringRef ref) const {
+  return std::string_view{stringTable}.substr(ref.offset, ref.size);
+}
+
+void NodeFileWriter::finish(uint64_t version, std::span<const NodeID> rootIDs) {
+  NodeFileHeader header{
+      .magic = magic,
+      .formatVersion = formatVersion,
+      .version = version,
+      .firstNodeID = firstNodeID,
+      .nodeCount = nodeCount,
+      .stringTableOffset = recordOffset(nodeCount),
+      .stringTableSize = stringTable.size(),
+      .rootIDsOffset = 0,
+      .rootIDsCount = rootIDs.size(),
+  };
+  header.rootIDsOffset =
+      alignUp(header.stringTableOffset + header.stringTableSize,
+              alignof(NodeID));
+
+  pwriteAll(stringTable.data(), stringTable.size(), header.stringTableOffset);
+  pwriteAll(rootIDs.data(), rootIDs.size_bytes(), header.rootIDsOffset);
+  if (ftruncate(fd, static_cast<off_t>(header.rootIDsOffset +
+                                       rootIDs.size_bytes())) == -1) {
+    throwErrno("Failed to truncate node file");
+  }
+  pwriteAll(&header, sizeof(header), 0);
+
+  close(fd);
+  fd = -1;
+}
+
+bool NodeFileReader::isNodeFile(const std::filesystem::path& path) {
+  std::ifstream ifs{path, std::ios_base::binary};
+  uint64_t fileMagic = 0;
+  ifs.read(reinterpret_cast<char*>(&fileMagic), sizeof(fileMagic));
+  return ifs && fileMagic == magic;
+}
+
+NodeFileReader::NodeFileReader(const std::filesystem::path& path) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    throwErrno("Failed to open node file '" + path.string() + "'");
+  }
+
+  struct stat st {};
+  if (fstat(fd, &st) == -1) {
+    close(fd);
+    throwErrno("Failed to stat node file '" + path.string() + "'");
+  }
+  size = static_cast<size_t>(st.st_size);
+
+  if (size < sizeof(NodeFileHeader)) {
+    close(fd);
+    throw std::runtime_error("Node file '" + path.string() +
+                             "' is too small");
+  }
+
+  data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    data = nullptr;
+    throwErrno("Failed to mmap node file '" + path.string() + "'");
+  }
+
+  try {
+    validate(path);
+  } catch (...) {
+    munmap(data, size);
+    data = nullptr;
+    throw;
+  }
+}
+
+void NodeFileReader::validate(const std::filesystem::path& path) {
+  const auto* bytes = static_cast<const char*>(data);
+  header_ = reinterpret_cast<const NodeFileHeader*>(bytes);
+  if (header_->magic != magic || header_->formatVersion != formatVersion) {
+    throw std::runtime_error("Invalid or unsupported node file '" +
+                             path.string() + "'");
+  }
+
+  if (recordOffset(header_->nodeCount) > header_->stringTableOffset ||
+      header_->stringTableOffset + header_->stringTableSize > size ||
+      header_->rootIDsOffset + header_->rootIDsCount * sizeof(NodeID) >
+          size) {
+    throw std::runtime_error("Node file '" + path.string() + "' is truncated");
+  }
+
+  nodes_ = {reinterpret_cast<const NodeRecord*>(bytes + recordOffset(0)),
+            header_->nodeCount};
+  stringTable_ = {bytes + header_->stringTableOffset,
+                  header_->stringTableSize};
+  rootIDs_ = {reinterpret_cast<const NodeID*>(bytes + header_->rootIDsOffset),
+              header_->rootIDsCount};
+}
+
+NodeFileReader::~NodeFileReader() {
+  if (data != nullptr) {
+    munmap(data, size);
+  }
+}
+
+const NodeRecord* NodeFileReader::node(NodeID id) const {
+  if (id < header_->firstNodeID || id - header_->firstNodeID >= nodes_.size()) {
+    return nullptr;
+  }
+
+  const auto& record = nodes_[id - header_->firstNodeID];
+  return record.has(NodeRecord::Written) ? &record : nullptr;
+}
+
+std::string_view NodeFileReader::getString(StringRef ref) const {
+  return stringTable_.substr(ref.offset, ref.size);
+}
+
+}  // namespace oi::detail::nodefile
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/*
+ * Node file: an append-only alternative to the RocksDB output of TreeBuilder.
+ *
+ * Node IDs are dense and sequential, so every node is stored as a fixed-width
+ * record at index `id - firstNodeID`. Records can be written in any order,
+ * which lets TreeBuilder emit children before their parent. Strings are
+ * interned into a string table that is appended once all nodes are written.
+ *
+ * Layout:
+ *   NodeFileHeader
+ *   NodeRecord[nodeCount]
+ *   char[stringTableSize]   (at stringTableOffset)
+ *   NodeID[rootIDsCount]    (at rootIDsOffset)
+ *
+ * Everything is naturally aligned so the file can be mmap'd and read in place.
+ */
+namespace oi::detail::nodefile {
+
+using NodeID = uint64_t;
+
+constexpr uint64_t magic = 0x5345444f4e494f00;  // "\0OINODES"
+constexpr uint64_t formatVersion = 2;
+
+struct StringRef {
+  uint64_t offset;
+  uint64_t size;
+};
+
+struct NodeFileHeader {
+  uint64_t magic;
+  uint64_t formatVersion;
+  /* Version of the TreeBuilder schema, matching the RocksDB DBHeader */
+  uint64_t version;
+  NodeID firstNodeID;
+  uint64_t nodeCount;
+  uint64_t stringTableOffset;
+  uint64_t stringTableSize;
+  uint64_t rootIDsOffset;
+  uint64_t rootIDsCount;
+};
+
+/*
+ * Fixed-width equivalent of TreeBuilder::Node. Optional fields are marked as
+ * present through `flags`.
+ */
+struct NodeRecord {
+  enum Flags : uint32_t {
+    Written = 1 << 0,
+    IsTypedef = 1 << 1,
+    HasPaddingSavingsSize = 1 << 2,
+    HasPointer = 1 << 3,
+    HasContainerStats = 1 << 4,
+    HasChildren = 1 << 5,
+    HasIsset = 1 << 6,
+    Isset = 1 << 7,
+    HasAggregateCount = 1 << 8,
+  };
+
+  NodeID id;
+  StringRef name;
+  StringRef typeName;
+  StringRef typePath;
+  uint64_t staticSize;
+  uint64_t dynamicSize;
+  uint64_t exclusiveSize;
+  uint64_t paddingSavingsSize;
+  uint64_t pointer;
+  uint64_t length;
+  uint64_t capacity;
+  uint64_t elementStaticSize;
+  uint64_t aggregateCount;
+  NodeID childrenStart;
+  NodeID childrenEnd;
+  uint32_t flags;
+  uint32_t reserved;
+
+  bool has(Flags flag) const {
+    return (flags & flag) != 0;
+  }
+};
+
+static_assert(sizeof(NodeFileHeader) % alignof(NodeRecord) == 0);
+static_assert(sizeof(NodeRecord) % alignof(NodeRecord) == 0);
+
+class NodeFileWriter {
+ public:
+  NodeFileWriter(const std::filesystem::path&, NodeID firstNodeID);
+  ~NodeFileWriter();
+
+  NodeFileWriter(const NodeFileWriter&) = delete;
+  NodeFileWriter& operator=(const NodeFileWriter&) = delete;
+
+  StringRef addString(std::string_view);
+  void write(const NodeRecord&);
+
+  NodeRecord read(NodeID) const;
+  std::string_view getString(StringRef) const;
+
+  /*
+   * Append the string table and the root IDs, then write the header. Nothing
+   * can be written after calling `finish`.
+   */
+  void finish(uint64_t version, std::span<const NodeID> rootIDs);
+
+ private:
+  int fd = -1;
+  NodeID firstNodeID;
+  uint64_t nodeCount = 0;
+
+  std::string stringTable;
+  std::unordered_map<std::string, StringRef> stringIndex;
+
+  void pwriteAll(const void*, size_t, uint64_t offset) const;
+};
+
+/*
+ * Read-only, zero-copy view of a node file through mmap.
+ */
+class NodeFileReader {
+ public:
+  explicit NodeFileReader(const std::filesystem::path&);
+  ~NodeFileReader();
+
+  NodeFileReader(const NodeFileReader&) = delete;
+  NodeFileReader& operator=(const NodeFileReader&) = delete;
+
+  /*
+   * Returns `true` if the file at the given path starts with the node file
+   * magic number.
+   */
+  static bool isNodeFile(const std::filesystem::path&);
+
+  const NodeFileHeader& header() const {
+    return *header_;
+  }
+
+  std::span<const NodeID> rootIDs() const {
+    return rootIDs_;
+  }
+
+  /*
+   * Returns the node with the given ID, or nullptr if there is no such node.
+   */
+  const NodeRecord* node(NodeID) const;
+  std::string_view getString(StringRef) const;
+
+ private:
+  void* data = nullptr;
+  size_t size = 0;
+
+  const NodeFileHeader* header_ = nullptr;
+  std::span<const NodeRecord> nodes_;
+  std::span<const NodeID> rootIDs_;
+  std::string_view stringTable_;
+
+  void validate(const std::filesystem::path&);
+};
+
+}  // namespace oi::detail::nodefile
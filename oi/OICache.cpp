@@ -17,8 +17,6 @@
 
 #include <glog/logging.h>
 
-#include <boost/archive/text_iarchive.hpp>
-#include <boost/archive/text_oarchive.hpp>
 #include <fstream>
 
 #include "oi/Descs.h"
@@ -67,14 +65,26 @@ std::optional<fs::path> OICache::getPath(const irequest& req,
     return std::to_string(std::hash<std::string>{}(str));
   };
 
-  auto ext = extensions[static_cast<size_t>(ent)];
+  // The base path can change when downloading, so only the names are kept
+  auto& fileName = fileNames[req][static_cast<size_t>(ent)];
+  if (fileName.empty()) {
+    const auto& entName = getEntName(*symbols, req, ent);
+    if (!entName.has_value()) {
+      return std::nullopt;
+    }
 
-  const auto& entName = getEntName(*symbols, req, ent);
-  if (!entName.has_value()) {
-    return std::nullopt;
+    fileName = hash(*entName) + extensions[static_cast<size_t>(ent)];
   }
 
-  return basePath / (hash(*entName) + ext);
+  return basePath / fileName;
+}
+
+std::optional<std::string> OICache::getBuildID() {
+  if (buildIDSymbols != symbols.get()) {
+    buildID = symbols->locateBuildID();
+    buildIDSymbols = symbols.get();
+  }
+  return buildID;
 }
 
 template <typename T>
@@ -82,7 +92,7 @@ bool OICache::load(const irequest& req, Entity ent, T& data) {
   if (!isEnabled())
     return false;
   try {
-    auto buildID = symbols->locateBuildID();
+    auto buildID = getBuildID();
     if (!buildID) {
       LOG(ERROR) << "Failed to locate buildID";
       return false;
@@ -97,8 +107,9 @@ bool OICache::load(const irequest& req, Entity ent, T& data) {
     }
 
     LOG(INFO) << "Loading cache " << *cachePath;
-    std::ifstream ifs(*cachePath);
-    boost::archive::text_iarchive ia(ifs);
+    std::ifstream ifs(*cachePath, std::ios_base::binary);
+    readCacheFileHeader(ifs);
+    CacheIArchive ia(ifs);
 
     std::string cacheBuildId;
     ia >> cacheBuildId;
@@ -122,7 +133,7 @@ bool OICache::store(const irequest& req, Entity ent, const T& data) {
   if (!isEnabled())
     return false;
   try {
-    auto buildID = symbols->locateBuildID();
+    auto buildID = getBuildID();
     if (!buildID) {
       LOG(ERROR) << "Failed to locate buildID";
       return false;
@@ -137,8 +148,9 @@ bool OICache::store(const irequest& req, Entity ent, const T& data) {
     }
 
     LOG(INFO) << "Storing cache " << *cachePath;
-    std::ofstream ofs(*cachePath);
-    boost::archive::text_oarchive oa(ofs);
+    std::ofstream ofs(*cachePath, std::ios_base::binary);
+    writeCacheFileHeader(ofs);
+    CacheOArchive oa(ofs);
 
     oa << *buildID;
     oa << data;
@@ -236,14 +248,15 @@ bool OICache::download([[maybe_unused]] const irequest& req) {
 }
 
 std::string OICache::generateRemoteHash(const irequest& req) {
-  auto buildID = symbols->locateBuildID();
+  auto buildID = getBuildID();
   if (!buildID) {
     LOG(ERROR) << "Failed to locate buildID";
     return "";
   }
 
   std::string remote_cache_id = *buildID + "/" + req.func + "/" + req.arg +
-                                "/" + generatorConfig.toString();
+                                "/" + generatorConfig.toString() + "/" +
+                                std::to_string(cacheFileFormatVersion);
 #ifndef OSS_ENABLE
   auto version_pair = ObjectIntrospection::GobsService::getOidRpmVersions();
   remote_cache_id += "/" + version_pair.first + "/" + version_pair.second;
@@ -19,6 +19,8 @@
 #include <filesystem>
 #include <memory>
 #include <optional>
+#include <string>
+#include <unordered_map>
 
 #include "oi/OICodeGen.h"
 #include "oi/OIParser.h"
@@ -71,6 +73,20 @@ class OICache {
 
  private:
   std::string generateRemoteHash(const irequest&);
+
+  /*
+   * Looking up the build ID walks the target's modules, and naming a cache
+   * file can require looking up the probed function or global's descriptor.
+   * Both are resolved once and remembered, as every load and store needs
+   * them.
+   */
+  std::optional<std::string> getBuildID();
+
+  const SymbolService* buildIDSymbols = nullptr;
+  std::optional<std::string> buildID;
+
+  using FileNames = std::array<std::string, static_cast<size_t>(Entity::MAX)>;
+  mutable std::unordered_map<irequest, FileNames> fileNames;
 };
 
 }  // namespace oi::detail
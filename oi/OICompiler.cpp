@@ -29,6 +29,7 @@
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/ADT/Triple.h>
 #include <llvm/ADT/Twine.h>
+#include <llvm/Config/llvm-config.h>
 #include <llvm/Demangle/Demangle.h>
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
 #include <llvm/ExecutionEngine/RTDyldMemoryManager.h>
@@ -41,9 +42,16 @@
 #include <array>
 #include <boost/range/combine.hpp>
 #include <boost/scope_exit.hpp>
+#include <boost/uuid/detail/sha1.hpp>
+#include <cctype>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
 
 #include "oi/Headers.h"
 #include "oi/Metrics.h"
+#include "oi/OIUtils.h"
 
 extern "C" {
 #include <llvm-c/Disassembler.h>
@@ -467,11 +475,127 @@ static void debugDisAsm(
   }
 }
 
-bool OICompiler::compile(const std::string& code,
-                         const fs::path& sourcePath,
-                         const fs::path& objectPath) {
-  metrics::Tracing _("compile");
+static const auto syntheticHeaders = std::array<
+    std::pair<Feature, std::pair<std::string_view, std::string>>, 7>{{
+    {Feature::TypedDataSegment, {headers::oi_types_st_h, "oi/types/st.h"}},
+    {Feature::TreeBuilderTypeChecking,
+     {headers::oi_types_dy_h, "oi/types/dy.h"}},
+    {Feature::TreeBuilderV2,
+     {headers::oi_exporters_inst_h, "oi/exporters/inst.h"}},
+    {Feature::TreeBuilderV2,
+     {headers::oi_exporters_ParsedData_h, "oi/exporters/ParsedData.h"}},
+    {Feature::TreeBuilderV2,
+     {headers::oi_result_Element_h, "oi/result/Element.h"}},
+    {Feature::Library,
+     {headers::oi_IntrospectionResult_h, "oi/IntrospectionResult.h"}},
+    {Feature::Library,
+     {headers::oi_IntrospectionResult_inl_h, "oi/IntrospectionResult-inl.h"}},
+}};
+
+std::string OICompiler::objectCacheKey(const std::string& code,
+                                       const fs::path& sourcePath) const {
+  return hashWithConfig({code, sourcePath.string()});
+}
+
+std::string OICompiler::precompiledHeaderKey(std::string_view prelude) const {
+  return hashWithConfig({"pch", prelude});
+}
+
+std::string OICompiler::hashWithConfig(
+    std::initializer_list<std::string_view> parts) const {
+  boost::uuids::detail::sha1 sha;
+  auto update = [&](std::string_view str) {
+    // Hash the size too, so that concatenated fields can't collide
+    uint64_t size = str.size();
+    sha.process_bytes(&size, sizeof(size));
+    sha.process_bytes(str.data(), str.size());
+  };
+
+  update(LLVM_VERSION_STRING);
+  for (const auto& part : parts) {
+    update(part);
+  }
+  update(config.usePIC ? "pic" : "static");
+  update(std::to_string(config.optimizationLevel));
+  for (const auto f : allFeatures) {
+    if (config.features[f]) {
+      update(featureToStr(f));
+    }
+  }
+  for (const auto& path : config.userHeaderPaths) {
+    update(path.string());
+  }
+  update("--");
+  for (const auto& path : config.sysHeaderPaths) {
+    update(path.string());
+  }
+  for (const auto& [k, v] : syntheticHeaders) {
+    if (config.features[k]) {
+      update(v.first);
+    }
+  }
+
+  boost::uuids::detail::sha1::digest_type digest;
+  sha.get_digest(digest);
+
+  std::ostringstream key;
+  const auto* bytes = reinterpret_cast<const unsigned char*>(&digest);
+  for (size_t i = 0; i < sizeof(digest); i++) {
+    key << std::hex << std::setw(2) << std::setfill('0')
+        << static_cast<unsigned>(bytes[i]);
+  }
+  return key.str();
+}
+
+bool OICompiler::loadCachedObject(const fs::path& cachedObject,
+                                  const fs::path& objectPath) const {
+  std::error_code ec;
+  if (!fs::exists(cachedObject, ec)) {
+    return false;
+  }
+
+  fs::copy_file(cachedObject, objectPath, fs::copy_options::overwrite_existing,
+                ec);
+  if (ec) {
+    LOG(WARNING) << "Failed to copy cached object " << cachedObject << " to "
+                 << objectPath << ": " << ec.message();
+    return false;
+  }
+  return true;
+}
+
+void OICompiler::storeCachedObject(const fs::path& objectPath,
+                                   const fs::path& cachedObject) const {
+  /*
+   * Copy to a temporary file first and rename it into place, so concurrent
+   * users of the cache never see a partially written object.
+   */
+  auto tmpObject = utils::temporaryPath(cachedObject);
+
+  std::error_code ec;
+  fs::create_directories(cachedObject.parent_path(), ec);
+  fs::copy_file(objectPath, tmpObject, fs::copy_options::overwrite_existing,
+                ec);
+  if (!ec) {
+    fs::rename(tmpObject, cachedObject, ec);
+  }
+  if (ec) {
+    LOG(WARNING) << "Failed to store object in cache " << cachedObject << ": "
+                 << ec.message();
+    fs::remove(tmpObject, ec);
+  }
+}
 
+/*
+ * Create an invocation compiling @param code as if it was the content of
+ * @param sourcePath. It is shared by the compilation of objects and of
+ * precompiled headers, whose options must match for the latter to be usable.
+ */
+static std::shared_ptr<CompilerInvocation> createInvocation(
+    const OICompiler::Config& config,
+    const fs::path& sourcePath,
+    std::string_view code,
+    InputKind inputKind) {
   /*
    * Note to whoever: if you're having problems compiling code, especially
    * header issues, then make sure you thoroughly read the options list in
@@ -501,9 +625,7 @@ bool OICompiler::compile(const std::string& code,
   compInv->getPreprocessorOpts().UsePredefines = true;
 
   compInv->getFrontendOpts().Inputs.push_back(
-      FrontendInputFile(sourcePath.string(), InputKind{Language::CXX}));
-  compInv->getFrontendOpts().OutputFile = objectPath.string();
-  compInv->getFrontendOpts().ProgramAction = clang::frontend::EmitObj;
+      FrontendInputFile(sourcePath.string(), inputKind));
 
   auto& headerSearchOptions = compInv->getHeaderSearchOpts();
 
@@ -518,22 +640,6 @@ bool OICompiler::compile(const std::string& code,
         path.c_str(), clang::frontend::IncludeDirGroup::System, false, false);
   }
 
-  static const auto syntheticHeaders = std::array<
-      std::pair<Feature, std::pair<std::string_view, std::string>>, 7>{{
-      {Feature::TypedDataSegment, {headers::oi_types_st_h, "oi/types/st.h"}},
-      {Feature::TreeBuilderTypeChecking,
-       {headers::oi_types_dy_h, "oi/types/dy.h"}},
-      {Feature::TreeBuilderV2,
-       {headers::oi_exporters_inst_h, "oi/exporters/inst.h"}},
-      {Feature::TreeBuilderV2,
-       {headers::oi_exporters_ParsedData_h, "oi/exporters/ParsedData.h"}},
-      {Feature::TreeBuilderV2,
-       {headers::oi_result_Element_h, "oi/result/Element.h"}},
-      {Feature::Library,
-       {headers::oi_IntrospectionResult_h, "oi/IntrospectionResult.h"}},
-      {Feature::Library,
-       {headers::oi_IntrospectionResult_inl_h, "oi/IntrospectionResult-inl.h"}},
-  }};
   for (const auto& [k, v] : syntheticHeaders) {
     if (!config.features[k])
       continue;
@@ -551,7 +657,6 @@ bool OICompiler::compile(const std::string& code,
     }
   }
 
-  compInv->getFrontendOpts().OutputFile = objectPath;
   compInv->getTargetOpts().Triple =
       llvm::Triple::normalize(llvm::sys::getProcessTriple());
   if (config.usePIC) {
@@ -559,8 +664,272 @@ bool OICompiler::compile(const std::string& code,
   } else {
     compInv->getCodeGenOpts().RelocationModel = llvm::Reloc::Static;
   }
+
+  return compInv;
+}
+
+/* Path the prelude is compiled from. It does not need to exist. */
+static const std::string preludePath = "/synthetic/prelude.h";
+
+/*
+ * Clang doesn't validate the precompiled header against the headers it was
+ * built from (see `compileObject`), and its key only covers the header search
+ * paths. The size and modification time of every header it read are recorded
+ * in this file instead, to notice headers upgraded in place (e.g. libstdc++ or
+ * folly).
+ */
+static fs::path inputsPath(fs::path pchPath) {
+  return pchPath.replace_extension(".inputs");
+}
+
+static std::optional<std::pair<uintmax_t, int64_t>> inputStamp(
+    const fs::path& path) {
+  std::error_code ec;
+  auto size = fs::file_size(path, ec);
+  if (ec) {
+    return std::nullopt;
+  }
+  auto mtime = fs::last_write_time(path, ec);
+  if (ec) {
+    return std::nullopt;
+  }
+  return std::make_pair(size, int64_t{mtime.time_since_epoch().count()});
+}
+
+/*
+ * Parse the prerequisites of a Makefile-style dependency file written by
+ * clang: whitespace separated paths following the target, where spaces are
+ * escaped with a backslash and `$` is doubled.
+ */
+static std::optional<std::vector<fs::path>> readDependencyFile(
+    const fs::path& depFile) {
+  std::ifstream ifs{depFile};
+  if (!ifs) {
+    return std::nullopt;
+  }
+  std::string content{std::istreambuf_iterator<char>(ifs), {}};
+
+  auto start = content.find(": ");
+  if (start == std::string::npos) {
+    return std::nullopt;
+  }
+
+  std::vector<fs::path> deps;
+  std::string dep;
+  for (size_t i = start + 2; i < content.size(); i++) {
+    char c = content[i];
+    char next = i + 1 < content.size() ? content[i + 1] : '\n';
+    if ((c == '\\' && next != '\n' && next != '\r') ||
+        (c == '$' && next == '$')) {
+      dep += content[++i];
+    } else if (c == '\\' || std::isspace(static_cast<unsigned char>(c))) {
+      if (!dep.empty()) {
+        deps.emplace_back(std::move(dep));
+        dep.clear();
+      }
+    } else {
+      dep += c;
+    }
+  }
+  if (!dep.empty()) {
+    deps.emplace_back(std::move(dep));
+  }
+  return deps;
+}
+
+static bool writeInputs(const fs::path& depFile, const fs::path& inputsFile) {
+  auto deps = readDependencyFile(depFile);
+  if (!deps.has_value()) {
+    return false;
+  }
+
+  std::ofstream ofs{inputsFile};
+  for (const auto& dep : *deps) {
+    if (dep.string().starts_with("/synthetic/")) {
+      continue;  // In-memory prelude and synthetic headers
+    }
+    auto stamp = inputStamp(dep);
+    if (!stamp.has_value()) {
+      return false;
+    }
+    ofs << stamp->first << ' ' << stamp->second << ' ' << dep.string() << '\n';
+  }
+  return static_cast<bool>(ofs);
+}
+
+static bool inputsUnchanged(const fs::path& inputsFile) {
+  std::ifstream ifs{inputsFile};
+  if (!ifs) {
+    return false;
+  }
+
+  uintmax_t size = 0;
+  int64_t mtime = 0;
+  std::string path;
+  while (ifs >> size >> mtime && std::getline(ifs >> std::ws, path)) {
+    if (inputStamp(path) != std::make_pair(size, mtime)) {
+      VLOG(1) << "Precompiled header input " << path << " has changed";
+      return false;
+    }
+  }
+  return ifs.eof();
+}
+
+bool OICompiler::buildPrecompiledHeader(std::string_view prelude,
+                                        const fs::path& pchPath) {
+  metrics::Tracing _("build_pch");
+
+  auto compInv = createInvocation(config, preludePath, prelude,
+                                  InputKind{Language::CXX}.getHeader());
+
+  auto tmpPch = utils::temporaryPath(pchPath);
+  compInv->getFrontendOpts().OutputFile = tmpPch.string();
+  compInv->getFrontendOpts().ProgramAction = clang::frontend::GeneratePCH;
+
+  auto tmpDeps = tmpPch;
+  tmpDeps += ".d";
+  auto& depOpts = compInv->getDependencyOutputOpts();
+  depOpts.OutputFile = tmpDeps.string();
+  depOpts.Targets = {pchPath.string()};
+  depOpts.IncludeSystemHeaders = true;
+
+  CompilerInstance compInstance;
+  compInstance.setInvocation(compInv);
+  compInstance.createDiagnostics();
+  GeneratePCHAction pchAction;
+
+  auto inputs = inputsPath(pchPath);
+  auto tmpInputs = utils::temporaryPath(inputs);
+  BOOST_SCOPE_EXIT_ALL(&) {
+    std::error_code ec;
+    fs::remove(tmpPch, ec);
+    fs::remove(tmpDeps, ec);
+    fs::remove(tmpInputs, ec);
+  };
+
+  if (!compInstance.ExecuteAction(pchAction)) {
+    LOG(WARNING) << "Failed to build precompiled header " << pchPath;
+    return false;
+  }
+  if (!writeInputs(tmpDeps, tmpInputs)) {
+    LOG(WARNING) << "Failed to record the inputs of precompiled header "
+                 << pchPath;
+    return false;
+  }
+
+  // The inputs are stored first: a header without them is never reused
+  std::error_code ec;
+  fs::rename(tmpInputs, inputs, ec);
+  if (!ec) {
+    fs::rename(tmpPch, pchPath, ec);
+  }
+  if (ec) {
+    LOG(WARNING) << "Failed to store precompiled header " << pchPath << ": "
+                 << ec.message();
+    return false;
+  }
+  return true;
+}
+
+std::optional<fs::path> OICompiler::getPrecompiledHeader(
+    std::string_view prelude) {
+  auto pchPath =
+      config.precompiledHeaderDir / (precompiledHeaderKey(prelude) + ".pch");
+
+  std::error_code ec;
+  if (fs::exists(pchPath, ec) && inputsUnchanged(inputsPath(pchPath))) {
+    metrics::Tracing::incrementCounter("pch_hit");
+    return pchPath;
+  }
+  metrics::Tracing::incrementCounter("pch_miss");
+
+  fs::create_directories(config.precompiledHeaderDir, ec);
+  if (!buildPrecompiledHeader(prelude, pchPath)) {
+    return std::nullopt;
+  }
+  return pchPath;
+}
+
+bool OICompiler::compile(const std::string& code,
+                         const fs::path& sourcePath,
+                         const fs::path& objectPath) {
+  std::optional<fs::path> cachedObject;
+  if (!config.objectCacheDir.empty()) {
+    cachedObject =
+        config.objectCacheDir / (objectCacheKey(code, sourcePath) + ".o");
+    if (loadCachedObject(*cachedObject, objectPath)) {
+      VLOG(1) << "Reusing cached object " << *cachedObject;
+      metrics::Tracing::incrementCounter("object_cache_hit");
+      return true;
+    }
+    metrics::Tracing::incrementCounter("object_cache_miss");
+  }
+
+  metrics::Tracing _("compile");
+
+  std::optional<fs::path> precompiledHeader;
+  auto preludeSize = code.find(preludeEnd);
+  if (!config.precompiledHeaderDir.empty() &&
+      preludeSize != std::string::npos) {
+    precompiledHeader =
+        getPrecompiledHeader(std::string_view{code}.substr(0, preludeSize));
+  }
+
+  /*
+   * The compile span also covers building the precompiled header on a miss.
+   * Compilations reusing one are counted, so that the savings can be read
+   * from the compile spans together with the `compile_with_pch` counter.
+   */
+  if (precompiledHeader.has_value()) {
+    VLOG(1) << "Compiling with precompiled header " << *precompiledHeader;
+    metrics::Tracing::incrementCounter("compile_with_pch");
+    metrics::Tracing::incrementCounter("pch_skipped_bytes", preludeSize);
+  }
+
+  if (!compileObject(code, sourcePath, objectPath, precompiledHeader)) {
+    return false;
+  }
+
+  if (cachedObject.has_value()) {
+    storeCachedObject(objectPath, *cachedObject);
+  }
+  return true;
+}
+
+bool OICompiler::compileObject(
+    const std::string& code,
+    const fs::path& sourcePath,
+    const fs::path& objectPath,
+    const std::optional<fs::path>& precompiledHeader) {
+  std::string_view source{code};
+  std::string_view prelude{};
+  if (precompiledHeader.has_value()) {
+    /* The prelude is provided by the precompiled header */
+    prelude = source.substr(0, source.find(preludeEnd));
+    source.remove_prefix(prelude.size());
+  }
+
+  auto compInv = createInvocation(config, sourcePath, source,
+                                  InputKind{Language::CXX});
+
+  if (precompiledHeader.has_value()) {
+    auto& preprocessorOpts = compInv->getPreprocessorOpts();
+    preprocessorOpts.ImplicitPCHInclude = precompiledHeader->string();
+    /*
+     * The precompiled header is built from an in-memory buffer, so clang has
+     * nothing to validate it against. `getPrecompiledHeader` checks the
+     * headers it was built from instead.
+     */
+    preprocessorOpts.DisablePCHOrModuleValidation =
+        DisableValidationForModuleKind::PCH;
+    preprocessorOpts.addRemappedFile(
+        preludePath, MemoryBuffer::getMemBufferCopy(prelude).release());
+  }
+
+  compInv->getFrontendOpts().OutputFile = objectPath.string();
+  compInv->getFrontendOpts().ProgramAction = clang::frontend::EmitObj;
   compInv->getCodeGenOpts().CodeModel = "large";
-  compInv->getCodeGenOpts().OptimizationLevel = 3;
+  compInv->getCodeGenOpts().OptimizationLevel = config.optimizationLevel;
   compInv->getCodeGenOpts().NoUseJumpTables = 1;
 
   if (config.features[Feature::GenJitDebug]) {
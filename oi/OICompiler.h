@@ -18,6 +18,7 @@
 #include <algorithm>
 #include <array>
 #include <filesystem>
+#include <initializer_list>
 #include <memory>
 #include <optional>
 #include <set>
@@ -50,8 +51,36 @@ class OICompiler {
     std::vector<fs::path> sysHeaderPaths{};
 
     bool usePIC = false;
+
+    /*
+     * Optimisation level of the generated code. Lower levels compile faster
+     * at the cost of a slower traversal of the target's objects.
+     */
+    int optimizationLevel = 3;
+
+    /*
+     * Directory of compiled objects indexed by a hash of their source code
+     * and of this configuration. When set, `compile()` reuses a matching
+     * object instead of running clang. Disabled when empty.
+     */
+    fs::path objectCacheDir{};
+
+    /*
+     * Directory of precompiled headers for the prelude of the generated code
+     * (see `preludeEnd`), indexed by a hash of the prelude and of this
+     * configuration. Disabled when empty.
+     */
+    fs::path precompiledHeaderDir{};
   };
 
+  /*
+   * Generated code containing this marker is split in two: everything before
+   * it is a prelude that only depends on the enabled features. The prelude is
+   * compiled once into a precompiled header, so that `compile()` only has to
+   * parse the type-specific code that follows the marker.
+   */
+  static constexpr std::string_view preludeEnd = "\n// OI: end of prelude\n";
+
   /**
    * The result of a call to `applyRelocs()`.
    * It contains the next BaseRelocAddress for further relocation,
@@ -143,6 +172,20 @@ class OICompiler {
    */
   bool compile(const std::string&, const fs::path&, const fs::path&);
 
+  /**
+   * @return the key identifying the object file built from @param code in the
+   * object cache. It covers everything that can change the output of
+   * `compile()`: the code itself, the compiler configuration and the version
+   * of the compiler and synthetic headers.
+   */
+  std::string objectCacheKey(const std::string&, const fs::path&) const;
+
+  /**
+   * @return the key identifying the precompiled header built from the
+   * @param prelude of some generated code.
+   */
+  std::string precompiledHeaderKey(std::string_view prelude) const;
+
   /**
    * Load the @param objectFiles in memory and apply relocation at
    * @param BaseRelocAddress. Note that it doesn't copy the object files at the
@@ -201,6 +244,20 @@ class OICompiler {
    * variable in the applyReloc function.
    */
   std::unique_ptr<OIMemoryManager> memMgr;
+
+  bool compileObject(const std::string&,
+                     const fs::path&,
+                     const fs::path&,
+                     const std::optional<fs::path>& precompiledHeader);
+  std::optional<fs::path> getPrecompiledHeader(std::string_view prelude);
+  bool buildPrecompiledHeader(std::string_view prelude,
+                              const fs::path& pchPath);
+  std::string hashWithConfig(
+      std::initializer_list<std::string_view> parts) const;
+  bool loadCachedObject(const fs::path& cachedObject,
+                        const fs::path& objectPath) const;
+  void storeCachedObject(const fs::path& objectPath,
+                         const fs::path& cachedObject) const;
 };
 
 template <class FuncTextRange, class NeedlesRange>
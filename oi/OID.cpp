@@ -18,19 +18,28 @@
 #include <glog/logging.h>
 
 #include <boost/scope_exit.hpp>
+#include <cerrno>
 #include <csignal>
 #include <cstdlib>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <map>
+#include <sstream>
 
 extern "C" {
 #include <getopt.h>
 #include <libgen.h>
+#include <malloc.h>
+#include <sys/stat.h>
+#include <unistd.h>
 }
 
 #include "oi/Features.h"
+#include "oi/LruCache.h"
 #include "oi/Metrics.h"
+#include "oi/OIDServer.h"
 #include "oi/OIDebugger.h"
 #include "oi/OIOpts.h"
 #include "oi/OIUtils.h"
@@ -61,6 +70,7 @@ enum ExitStatus {
   ProcessingTargetDataError,
   OidObjectError,
   CacheUploadError,
+  ServerConnectionError,
 };
 }
 
@@ -109,6 +119,26 @@ constexpr static OIOpts opts{
     OIOpt{'x', "data-buf-size", required_argument, "<bytes>",
           "Size of data segment (default:1MB)\n"
           "Accepts multiplicative suffix: K, M, G, T, P, E"},
+    OIOpt{'P', "pointer-set-size", required_argument, "<bytes>",
+          "Initial size of the JIT code's pointer set (default:1MB)\n"
+          "The set grows as needed while probing\n"
+          "Accepts multiplicative suffix: K, M, G, T, P, E"},
+    OIOpt{'O', "optimization-level", required_argument, "<0-3>",
+          "Optimisation level of the JIT code (default:3)\n"
+          "Lower levels compile faster but probe more slowly"},
+    OIOpt{'L', "listen", required_argument, "<socket>",
+          "Keep running and serve probe requests sent to <socket>\n"
+          "Debug info and generated code are kept warm between requests\n"
+          "Probes are cached in $XDG_CACHE_HOME/oid (default: ~/.cache/oid)\n"
+          "unless '-o' is given"},
+    OIOpt{'C', "connect", required_argument, "<socket>",
+          "Send the probe to the oid listening on <socket>\n"
+          "Only '-p', '-s', '-S', '-t', '-J' and '-n' are forwarded"},
+    OIOpt{'W', "warm-binaries", required_argument, "<count>",
+          "Number of binaries a listening oid keeps warm (default:4)"},
+    OIOpt{'R', "warm-memory-limit", required_argument, "<bytes>",
+          "Evict warm binaries while a listening oid uses more memory\n"
+          "Accepts multiplicative suffix: K, M, G, T, P, E"},
     OIOpt{'d', "debug-level", required_argument, "<level>",
           "Verbose level for logging"},
     OIOpt{'r', "remove-mappings", no_argument, nullptr,
@@ -137,6 +167,12 @@ constexpr static OIOpts opts{
     OIOpt{'J', "dump-json", optional_argument, "[oid_out.json]",
           "File to dump the results to, as JSON\n"
           "(in addition to the default RocksDB output)"},
+    OIOpt{'n', "node-file", required_argument, "<path>",
+          "Write the results to a columnar node file at <path>\n"
+          "(instead of the default RocksDB output)"},
+    OIOpt{'A', "aggregate-elements", no_argument, nullptr,
+          "Summarise the elements of containers which have no dynamic size\n"
+          "as a single node per element type, instead of a node per element"},
     OIOpt{
         'B', "dump-data-segment", no_argument, nullptr,
         "Dump the data segment's content, before TreeBuilder processes it\n"
@@ -253,6 +289,7 @@ struct Config {
   fs::path cacheBasePath;
   fs::path customCodeFile;
   size_t dataSegSize;
+  size_t pointerSetSize;
   int timeout_s;
   bool cacheRemoteUpload;
   bool cacheRemoteDownload;
@@ -266,13 +303,24 @@ struct Config {
 
 }  // namespace Oid
 
+/*
+ * State a listening oid keeps for every binary it has probed, so that probing
+ * another process running the same binary doesn't have to reload its debug
+ * info or regenerate code for the probes it has already seen.
+ */
+struct WarmBinary {
+  std::shared_ptr<SymbolService> symbols;
+  std::shared_ptr<OIDebugger::TypeInfos> typeInfos;
+};
+
 static ExitStatus::ExitStatus runScript(
     const std::string& fileName,
     std::istream& script,
     const Oid::Config& oidConfig,
     const OICodeGen::Config& codeGenConfig,
     const OICompiler::Config& compilerConfig,
-    const TreeBuilder::Config& tbConfig) {
+    const TreeBuilder::Config& tbConfig,
+    const WarmBinary* warm = nullptr) {
   if (!fileName.empty()) {
     VLOG(1) << "SCR FILE: " << fileName;
   }
@@ -280,7 +328,11 @@ static ExitStatus::ExitStatus runScript(
   auto progStart = time_hr::now();
 
   std::shared_ptr<OIDebugger> oid;  // share oid with the global signal handler
-  if (oidConfig.pid != 0) {
+  if (warm != nullptr) {
+    oid = std::make_shared<OIDebugger>(oidConfig.pid, warm->symbols,
+                                       codeGenConfig, compilerConfig, tbConfig);
+    oid->setTypeInfos(warm->typeInfos);
+  } else if (oidConfig.pid != 0) {
     oid = std::make_shared<OIDebugger>(oidConfig.pid, codeGenConfig,
                                        compilerConfig, tbConfig);
   } else {
@@ -346,6 +398,9 @@ static ExitStatus::ExitStatus runScript(
     if (oidConfig.dataSegSize > 0) {
       oid->setDataSegmentSize(oidConfig.dataSegSize);
     }
+    if (oidConfig.pointerSetSize > 0) {
+      oid->setPointerSetSize(oidConfig.pointerSetSize);
+    }
 
     if (!oid->segmentInit()) {
       oid->contTargetThread();
@@ -456,6 +511,197 @@ static ExitStatus::ExitStatus runScript(
   return ExitStatus::Success;
 }
 
+static size_t residentSetSize() {
+  std::ifstream statm("/proc/self/statm");
+  size_t totalPages = 0;
+  size_t residentPages = 0;
+  statm >> totalPages >> residentPages;
+  return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+/*
+ * The listening oid's default cache directory, under the user's cache
+ * directory. Cached probes are injected into the processes being probed, so
+ * the directory must be private to the current user: with a shared, well
+ * known path, another local user could plant objects for the server to load.
+ */
+static std::optional<fs::path> defaultServerCacheDir() {
+  fs::path base;
+  if (const char* xdg = getenv("XDG_CACHE_HOME");
+      xdg != nullptr && *xdg == '/') {
+    base = xdg;
+  } else if (const char* home = getenv("HOME");
+             home != nullptr && *home == '/') {
+    base = fs::path(home) / ".cache";
+  } else {
+    LOG(ERROR) << "Neither XDG_CACHE_HOME nor HOME is set, use '-o' to choose "
+                  "the cache directory";
+    return std::nullopt;
+  }
+
+  auto dir = base / "oid";
+  std::error_code ec;
+  fs::create_directories(base, ec);
+  if (mkdir(dir.c_str(), 0700) == -1 && errno != EEXIST) {
+    LOG(ERROR) << "Failed to create cache directory " << dir << ": "
+               << std::strerror(errno);
+    return std::nullopt;
+  }
+
+  struct stat st {};
+  if (lstat(dir.c_str(), &st) == -1 || !S_ISDIR(st.st_mode) ||
+      st.st_uid != geteuid() || (st.st_mode & 0077) != 0) {
+    LOG(ERROR) << "Refusing to use cache directory " << dir
+               << ": it must be a directory only accessible to its owner, "
+                  "the current user";
+    return std::nullopt;
+  }
+  return dir;
+}
+
+static std::optional<std::string> optionalPath(const std::string& path) {
+  if (path.empty()) {
+    return std::nullopt;
+  }
+  return path;
+}
+
+static ExitStatus::ExitStatus runServer(
+    const fs::path& socketPath,
+    size_t maxWarmBinaries,
+    size_t maxResidentBytes,
+    const Oid::Config& oidConfig,
+    const OICodeGen::Config& codeGenConfig,
+    const OICompiler::Config& baseCompilerConfig,
+    const TreeBuilder::Config& tbConfig) {
+  /*
+   * OICache names its files after the probed type only, so each binary gets a
+   * cache directory of its own, named after its build ID. Compiled objects and
+   * PCHs are keyed by their contents and can still be shared by all binaries.
+   */
+  auto compilerConfig = baseCompilerConfig;
+  if (compilerConfig.objectCacheDir.empty()) {
+    compilerConfig.objectCacheDir = oidConfig.cacheBasePath / "objects";
+  }
+  if (compilerConfig.precompiledHeaderDir.empty()) {
+    compilerConfig.precompiledHeaderDir = oidConfig.cacheBasePath / "pch";
+  }
+
+  std::optional<OIDServer> server;
+  try {
+    server.emplace(socketPath);
+  } catch (const std::exception& e) {
+    LOG(ERROR) << e.what();
+    return ExitStatus::UsageError;
+  }
+
+  LruCache<std::string, WarmBinary> warmBinaries{maxWarmBinaries};
+
+  server->serve([&](const OIDRequest& req) -> int {
+    Oid::Config reqConfig = oidConfig;
+    reqConfig.pid = req.pid;
+    reqConfig.timeout_s = req.timeout_s;
+    std::istringstream script(req.script);
+
+    TreeBuilder::Config reqTbConfig = tbConfig;
+    reqTbConfig.jsonPath = optionalPath(req.jsonPath);
+    reqTbConfig.nodeFilePath = optionalPath(req.nodeFilePath);
+    reqTbConfig.dbPath = optionalPath(req.dbPath);
+
+    /*
+     * Attaching a SymbolService is cheap, it's loading the debug info that's
+     * expensive. The fresh service is only used to find the build ID unless
+     * this binary hasn't been seen before.
+     */
+    std::shared_ptr<SymbolService> symbols;
+    try {
+      symbols = std::make_shared<SymbolService>(req.pid);
+    } catch (const std::exception& e) {
+      LOG(ERROR) << e.what();
+      return ExitStatus::StopTargetError;
+    }
+
+    auto buildID = symbols->locateBuildID();
+    if (!buildID.has_value()) {
+      LOG(WARNING) << "No build ID for process " << req.pid
+                   << ", its symbols and probes won't be cached";
+      reqConfig.cacheBasePath.clear();
+      WarmBinary cold{symbols, std::make_shared<OIDebugger::TypeInfos>()};
+      return runScript("", script, reqConfig, codeGenConfig, compilerConfig,
+                       reqTbConfig, &cold);
+    }
+
+    WarmBinary* warm = warmBinaries.get(*buildID);
+    if (warm != nullptr && warm->symbols->retarget(req.pid)) {
+      VLOG(1) << "Reusing warm symbols for build ID " << *buildID;
+    } else {
+      warm = &warmBinaries.put(
+          *buildID,
+          WarmBinary{symbols, std::make_shared<OIDebugger::TypeInfos>()});
+    }
+
+    reqConfig.cacheBasePath = oidConfig.cacheBasePath / *buildID;
+    std::error_code ec;
+    fs::create_directories(reqConfig.cacheBasePath, ec);
+    if (ec) {
+      LOG(ERROR) << "Failed to create cache directory "
+                 << reqConfig.cacheBasePath << ": " << ec.message();
+      return ExitStatus::UsageError;
+    }
+
+    auto status = runScript("", script, reqConfig, codeGenConfig,
+                            compilerConfig, reqTbConfig, warm);
+
+    // The binary just probed is the most recently used, so it always stays
+    while (maxResidentBytes > 0 && warmBinaries.size() > 1 &&
+           residentSetSize() > maxResidentBytes) {
+      warmBinaries.evictOldest();
+      malloc_trim(0);
+    }
+
+    return status;
+  });
+}
+
+static ExitStatus::ExitStatus runClient(
+    const fs::path& socketPath,
+    const Oid::Config& oidConfig,
+    const std::string& scriptFile,
+    const std::string& scriptSource,
+    const std::optional<fs::path>& jsonPath,
+    const std::optional<fs::path>& nodeFilePath) {
+  OIDRequest req{
+      .pid = oidConfig.pid,
+      .timeout_s = oidConfig.timeout_s,
+      .script = scriptSource,
+  };
+
+  // The outputs are the same as when probing without a server
+  if (jsonPath.has_value()) {
+    req.jsonPath = fs::absolute(*jsonPath).string();
+  }
+  if (nodeFilePath.has_value()) {
+    req.nodeFilePath = fs::absolute(*nodeFilePath).string();
+  } else {
+    req.dbPath = "/tmp/testdb_" + std::to_string(getpid());
+  }
+
+  if (!scriptFile.empty()) {
+    std::ifstream script(scriptFile);
+    if (!script) {
+      LOG(ERROR) << "Non-existent script file: " << scriptFile;
+      return ExitStatus::FileNotFoundError;
+    }
+    req.script.assign(std::istreambuf_iterator<char>(script), {});
+  }
+
+  auto status = OIDServer::send(socketPath, req);
+  if (!status.has_value()) {
+    return ExitStatus::ServerConnectionError;
+  }
+  return static_cast<ExitStatus::ExitStatus>(*status);
+}
+
 }  // namespace oi::detail
 
 int main(int argc, char* argv[]) {
@@ -467,6 +713,12 @@ int main(int argc, char* argv[]) {
   std::string scriptSource;
   std::string configGenOption;
   std::optional<fs::path> jsonPath{std::nullopt};
+  std::optional<fs::path> nodeFilePath{std::nullopt};
+  std::optional<int> optimizationLevel{std::nullopt};
+  fs::path listenSocket;
+  fs::path connectSocket;
+  size_t maxWarmBinaries = 4;
+  size_t maxResidentBytes = 0;
 
   std::map<Feature, bool> features = {
       {Feature::PackStructs, true},
@@ -476,6 +728,7 @@ int main(int argc, char* argv[]) {
 
   bool logAllStructs = true;
   bool dumpDataSegment = false;
+  bool aggregateElements = false;
 
   metrics::Tracing _("main");
 #ifndef OSS_ENABLE
@@ -530,9 +783,58 @@ int main(int argc, char* argv[]) {
         oidConfig.dataSegSize = static_cast<size_t>(dataSegSizeArg.value());
         break;
       }
+      case 'P': {
+        auto pointerSetSizeArg = strunittol(optarg);
+        if (!pointerSetSizeArg.has_value() || pointerSetSizeArg.value() <= 0) {
+          LOG(ERROR) << "Invalid value specified for pointer set size";
+          usage();
+          return ExitStatus::UsageError;
+        }
+        oidConfig.pointerSetSize =
+            static_cast<size_t>(pointerSetSizeArg.value());
+        break;
+      }
       case 'p':
         oidConfig.pid = atoi(optarg);
         break;
+      case 'O': {
+        char* end = nullptr;
+        long level = strtol(optarg, &end, 10);
+        if (*optarg == '\0' || *end != '\0' || level < 0 || level > 3) {
+          LOG(ERROR) << "Invalid value specified for optimization level";
+          usage();
+          return ExitStatus::UsageError;
+        }
+        optimizationLevel = static_cast<int>(level);
+        break;
+      }
+      case 'L':
+        listenSocket = optarg;
+        break;
+      case 'C':
+        connectSocket = optarg;
+        break;
+      case 'W': {
+        char* end = nullptr;
+        long count = strtol(optarg, &end, 10);
+        if (*optarg == '\0' || *end != '\0' || count <= 0) {
+          LOG(ERROR) << "Invalid value specified for warm binaries";
+          usage();
+          return ExitStatus::UsageError;
+        }
+        maxWarmBinaries = static_cast<size_t>(count);
+        break;
+      }
+      case 'R': {
+        auto memoryArg = strunittol(optarg);
+        if (!memoryArg.has_value() || memoryArg.value() <= 0) {
+          LOG(ERROR) << "Invalid value specified for warm memory limit";
+          usage();
+          return ExitStatus::UsageError;
+        }
+        maxResidentBytes = static_cast<size_t>(memoryArg.value());
+        break;
+      }
       case 'd':
         debugLevel = atoi(optarg);
         google::LogToStderr();
@@ -608,6 +910,9 @@ int main(int argc, char* argv[]) {
       case 'a':
         logAllStructs = true;
         break;
+      case 'A':
+        aggregateElements = true;
+        break;
       case 'B':
         dumpDataSegment = true;
         break;
@@ -623,6 +928,9 @@ int main(int argc, char* argv[]) {
       case 'J':
         jsonPath = optarg != nullptr ? optarg : "oid_out.json";
         break;
+      case 'n':
+        nodeFilePath = optarg;
+        break;
       case 'h':
       default:
         usage();
@@ -630,6 +938,17 @@ int main(int argc, char* argv[]) {
     }
   }
 
+  if (!connectSocket.empty()) {
+    if (oidConfig.pid == 0 || (scriptFile.empty() && scriptSource.empty())) {
+      LOG(INFO) << "'-C' requires '-p' and one of '-s' or '-S'";
+      usage();
+      return ExitStatus::UsageError;
+    }
+    // The listening oid probes with its own configuration
+    return runClient(connectSocket, oidConfig, scriptFile, scriptSource,
+                     jsonPath, nodeFilePath);
+  }
+
   if (oidConfig.configFile.empty()) {
     oidConfig.configFile = "/usr/local/share/oi/base.oid.toml";
 
@@ -649,16 +968,28 @@ int main(int argc, char* argv[]) {
     return ExitStatus::UsageError;
   }
 
-  if ((oidConfig.pid == 0 && oidConfig.debugInfoFile.empty()) ||
-      oidConfig.configFile.empty()) {
-    usage();
-    return ExitStatus::UsageError;
-  }
+  if (!listenSocket.empty()) {
+    if (oidConfig.pid != 0 || !oidConfig.debugInfoFile.empty() ||
+        !scriptFile.empty() || !scriptSource.empty() ||
+        jsonPath.has_value() || nodeFilePath.has_value()) {
+      LOG(INFO) << "'-L' takes the target, script and outputs from each "
+                   "request";
+      usage();
+      return ExitStatus::UsageError;
+    }
+  } else {
+    if ((oidConfig.pid == 0 && oidConfig.debugInfoFile.empty()) ||
+        oidConfig.configFile.empty()) {
+      usage();
+      return ExitStatus::UsageError;
+    }
 
-  if (!oidConfig.removeMappings && scriptFile.empty() && scriptSource.empty()) {
-    LOG(INFO) << "One of '-s', '-r' or '-S' must be specified";
-    usage();
-    return ExitStatus::UsageError;
+    if (!oidConfig.removeMappings && scriptFile.empty() &&
+        scriptSource.empty()) {
+      LOG(INFO) << "One of '-s', '-r' or '-S' must be specified";
+      usage();
+      return ExitStatus::UsageError;
+    }
   }
 
   /*
@@ -680,6 +1011,9 @@ int main(int argc, char* argv[]) {
       .logAllStructs = logAllStructs,
       .dumpDataSegment = dumpDataSegment,
       .jsonPath = jsonPath,
+      .nodeFilePath = nodeFilePath,
+      .dbPath = std::nullopt,
+      .aggregateElements = aggregateElements,
   };
 
   auto featureSet = utils::processConfigFile(oidConfig.configFile, features,
@@ -690,6 +1024,23 @@ int main(int argc, char* argv[]) {
   compilerConfig.features = *featureSet;
   codeGenConfig.features = *featureSet;
   tbConfig.features = *featureSet;
+  if (optimizationLevel.has_value()) {
+    // The command line takes precedence over the config file
+    compilerConfig.optimizationLevel = *optimizationLevel;
+  }
+
+  if (!listenSocket.empty()) {
+    if (oidConfig.cacheBasePath.empty()) {
+      // Keep the compiled probes around for the next request
+      auto cacheDir = defaultServerCacheDir();
+      if (!cacheDir.has_value()) {
+        return ExitStatus::UsageError;
+      }
+      oidConfig.cacheBasePath = *cacheDir;
+    }
+    return runServer(listenSocket, maxWarmBinaries, maxResidentBytes,
+                     oidConfig, codeGenConfig, compilerConfig, tbConfig);
+  }
 
   if (!scriptFile.empty()) {
     if (!std::filesystem::exists(scriptFile)) {
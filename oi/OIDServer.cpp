@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "oi/OIDServer.h"
+
+#include <glog/logging.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+extern "C" {
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+}
+
+namespace oi::detail {
+
+namespace {
+
+constexpr uint64_t requestMagic = 0x3251455244494f00;  // "\0OIDREQ2"
+
+/* Guard against garbage on the socket making us allocate gigabytes */
+constexpr uint64_t maxScriptSize = 1 << 20;
+constexpr uint64_t maxPathSize = 4096;
+
+/*
+ * Requests are served one at a time, so a client that stalls while sending
+ * its request or receiving the response mustn't hold up the others for long.
+ */
+constexpr std::chrono::seconds ioTimeout{10};
+
+using Deadline = std::chrono::steady_clock::time_point;
+
+struct RequestHeader {
+  uint64_t magic;
+  int32_t pid;
+  int32_t timeout_s;
+  uint64_t scriptSize;
+  uint64_t jsonPathSize;
+  uint64_t nodeFilePathSize;
+  uint64_t dbPathSize;
+};
+
+/*
+ * Read exactly `size` bytes, giving up at `deadline` if there's one.
+ */
+bool readAll(int fd,
+             void* buf,
+             size_t size,
+             std::optional<Deadline> deadline = std::nullopt) {
+  auto* bytes = static_cast<char*>(buf);
+  while (size > 0) {
+    if (deadline.has_value()) {
+      auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+          *deadline - std::chrono::steady_clock::now());
+      if (remaining.count() <= 0) {
+        return false;
+      }
+      pollfd pfd{.fd = fd, .events = POLLIN, .revents = 0};
+      auto ready = poll(&pfd, 1, static_cast<int>(remaining.count()));
+      if (ready == -1 && errno == EINTR) {
+        continue;
+      }
+      if (ready <= 0) {
+        return false;
+      }
+    }
+
+    auto n = read(fd, bytes, size);
+    if (n == -1 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    bytes += n;
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+bool writeAll(int fd, const void* buf, size_t size) {
+  const auto* bytes = static_cast<const char*>(buf);
+  while (size > 0) {
+    // A client hanging up must not kill the server with SIGPIPE
+    auto n = ::send(fd, bytes, size, MSG_NOSIGNAL);
+    if (n == -1 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    bytes += n;
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+sockaddr_un makeAddress(const std::filesystem::path& socketPath) {
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (socketPath.native().size() >= sizeof(addr.sun_path)) {
+    throw std::runtime_error("Socket path is too long: " + socketPath.string());
+  }
+  std::strcpy(addr.sun_path, socketPath.c_str());
+  return addr;
+}
+
+/*
+ * Only the user running the server may send it requests: a request makes oid
+ * attach to and inject code into an arbitrary process.
+ */
+bool isPeerAllowed(int conn) {
+  ucred cred{};
+  socklen_t len = sizeof(cred);
+  if (getsockopt(conn, SOL_SOCKET, SO_PEERCRED, &cred, &len) == -1) {
+    LOG(ERROR) << "getsockopt(SO_PEERCRED) error: " << std::strerror(errno);
+    return false;
+  }
+  if (cred.uid != geteuid()) {
+    LOG(WARNING) << "Refusing request from uid " << cred.uid << " (pid "
+                 << cred.pid << ")";
+    return false;
+  }
+  return true;
+}
+
+bool setSendTimeout(int conn) {
+  timeval timeout{.tv_sec = ioTimeout.count(), .tv_usec = 0};
+  if (setsockopt(conn, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) ==
+      -1) {
+    LOG(ERROR) << "setsockopt(SO_SNDTIMEO) error: " << std::strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+OIDServer::OIDServer(std::filesystem::path socketPath_)
+    : socketPath{std::move(socketPath_)} {
+  auto addr = makeAddress(socketPath);
+
+  fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd == -1) {
+    throw std::runtime_error(std::string("Failed to create socket: ") +
+                             std::strerror(errno));
+  }
+
+  // Remove the socket of a previous server that didn't exit cleanly, but
+  // never anything else that happens to be at the given path
+  struct stat st {};
+  if (lstat(socketPath.c_str(), &st) == 0) {
+    if (!S_ISSOCK(st.st_mode)) {
+      close(fd);
+      throw std::runtime_error("Refusing to replace '" + socketPath.string() +
+                               "': not a socket");
+    }
+    unlink(socketPath.c_str());
+  }
+
+  // Create the socket accessible to its owner only. umask() can't fail, so
+  // it leaves errno alone.
+  auto oldMask = umask(0077);
+  auto bound = bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+  umask(oldMask);
+
+  if (bound == -1 || chmod(socketPath.c_str(), 0600) == -1 ||
+      listen(fd, SOMAXCONN) == -1) {
+    auto err = errno;
+    close(fd);
+    throw std::runtime_error("Failed to listen on '" + socketPath.string() +
+                             "': " + std::strerror(err));
+  }
+
+  LOG(INFO) << "Listening for probe requests on " << socketPath;
+}
+
+OIDServer::~OIDServer() {
+  if (fd != -1) {
+    close(fd);
+    unlink(socketPath.c_str());
+  }
+}
+
+void OIDServer::serve(const Handler& handler) {
+  while (true) {
+    int conn = accept4(fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (conn == -1) {
+      if (errno != EINTR) {
+        LOG(ERROR) << "accept4() error: " << std::strerror(errno);
+      }
+      continue;
+    }
+
+    if (isPeerAllowed(conn) && setSendTimeout(conn)) {
+      handleConnection(conn, handler);
+    }
+    close(conn);
+  }
+}
+
+void OIDServer::handleConnection(int conn, const Handler& handler) {
+  // The whole request must arrive in time, not just each part of it
+  auto deadline = std::chrono::steady_clock::now() + ioTimeout;
+
+  RequestHeader header{};
+  if (!readAll(conn, &header, sizeof(header), deadline) ||
+      header.magic != requestMagic || header.scriptSize > maxScriptSize ||
+      header.jsonPathSize > maxPathSize ||
+      header.nodeFilePathSize > maxPathSize ||
+      header.dbPathSize > maxPathSize) {
+    LOG(ERROR) << "Received an invalid request, ignoring it";
+    return;
+  }
+
+  OIDRequest req{
+      .pid = header.pid,
+      .timeout_s = header.timeout_s,
+      .script = std::string(header.scriptSize, '\0'),
+      .jsonPath = std::string(header.jsonPathSize, '\0'),
+      .nodeFilePath = std::string(header.nodeFilePathSize, '\0'),
+      .dbPath = std::string(header.dbPathSize, '\0'),
+  };
+  if (!readAll(conn, req.script.data(), req.script.size(), deadline) ||
+      !readAll(conn, req.jsonPath.data(), req.jsonPath.size(), deadline) ||
+      !readAll(conn, req.nodeFilePath.data(), req.nodeFilePath.size(),
+               deadline) ||
+      !readAll(conn, req.dbPath.data(), req.dbPath.size(), deadline)) {
+    LOG(ERROR) << "Received a truncated request, ignoring it";
+    return;
+  }
+
+  LOG(INFO) << "Probing process " << req.pid << " with: " << req.script;
+  int32_t status = handler(req);
+
+  if (!writeAll(conn, &status, sizeof(status))) {
+    LOG(ERROR) << "Failed to send the exit status of the request for process "
+               << req.pid;
+  }
+}
+
+std::optional<int> OIDServer::send(const std::filesystem::path& socketPath,
+                                   const OIDRequest& req) {
+  auto addr = makeAddress(socketPath);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd == -1) {
+    LOG(ERROR) << "Failed to create socket: " << std::strerror(errno);
+    return std::nullopt;
+  }
+
+  RequestHeader header{
+      .magic = requestMagic,
+      .pid = req.pid,
+      .timeout_s = req.timeout_s,
+      .scriptSize = req.script.size(),
+      .jsonPathSize = req.jsonPath.size(),
+      .nodeFilePathSize = req.nodeFilePath.size(),
+      .dbPathSize = req.dbPath.size(),
+  };
+
+  int32_t status = 0;
+  bool ok =
+      connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != -1 &&
+      writeAll(fd, &header, sizeof(header)) &&
+      writeAll(fd, req.script.data(), req.script.size()) &&
+      writeAll(fd, req.jsonPath.data(), req.jsonPath.size()) &&
+      writeAll(fd, req.nodeFilePath.data(), req.nodeFilePath.size()) &&
+      writeAll(fd, req.dbPath.data(), req.dbPath.size()) &&
+      readAll(fd, &status, sizeof(status));
+  if (!ok) {
+    LOG(ERROR) << "Failed to send request to '" << socketPath.string()
+               << "': " << std::strerror(errno);
+  }
+
+  close(fd);
+  return ok ? std::optional<int>{status} : std::nullopt;
+}
+
+}  // namespace oi::detail
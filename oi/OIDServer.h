@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+
+extern "C" {
+#include <sys/types.h>
+}
+
+namespace oi::detail {
+
+/*
+ * A probe request sent to a long-running oid, equivalent to running
+ * `oid -p <pid> -S <script> -t <timeout>` against the server's configuration.
+ *
+ * The results go where the client asks, as each request would otherwise
+ * overwrite the previous one's. Paths are absolute, as the server doesn't
+ * share the client's working directory.
+ */
+struct OIDRequest {
+  pid_t pid;
+  int timeout_s;
+  std::string script;
+  // JSON output, as with `-J`. None if empty.
+  std::string jsonPath;
+  // Node file output, as with `-n`. RocksDB output at `dbPath` if empty.
+  std::string nodeFilePath;
+  std::string dbPath;
+};
+
+/*
+ * OIDServer
+ *
+ * Listens on a Unix socket and hands the probe requests it receives to a
+ * handler, one at a time: probing a process involves ptrace and global signal
+ * handlers, so requests are never run concurrently. The handler's return
+ * value, an oid exit status, is sent back to the client.
+ *
+ * The socket is only accessible to its owner, and connections from any other
+ * user are refused. Connections are dropped if sending the request or
+ * receiving the response stalls, so one client can't block the others.
+ *
+ * Wire format: a RequestHeader followed by the script and the output paths,
+ * each of the size given in the header, then an int32_t exit status in
+ * response.
+ */
+class OIDServer {
+ public:
+  using Handler = std::function<int(const OIDRequest&)>;
+
+  explicit OIDServer(std::filesystem::path socketPath);
+  ~OIDServer();
+
+  OIDServer(const OIDServer&) = delete;
+  OIDServer& operator=(const OIDServer&) = delete;
+
+  /*
+   * Serve requests until the process is terminated.
+   */
+  [[noreturn]] void serve(const Handler&);
+
+  /*
+   * Send a request to the server listening on `socketPath` and wait for its
+   * exit status. Returns std::nullopt if the server couldn't be reached.
+   */
+  static std::optional<int> send(const std::filesystem::path& socketPath,
+                                 const OIDRequest&);
+
+ private:
+  std::filesystem::path socketPath;
+  int fd = -1;
+
+  void handleConnection(int conn, const Handler&);
+};
+
+}  // namespace oi::detail
@@ -15,9 +15,8 @@
  */
 #include "oi/OIDebugger.h"
 
-#include <folly/Varint.h>
-
 #include <algorithm>
+#include <atomic>
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/join.hpp>
 #include <boost/algorithm/string/split.hpp>
@@ -28,10 +27,12 @@
 #include <cassert>
 #include <cerrno>
 #include <chrono>
+#include <climits>
 #include <cstddef>
 #include <cstring>
 #include <numeric>
 #include <span>
+#include <thread>
 
 extern "C" {
 #include <fcntl.h>
@@ -1446,8 +1447,8 @@ bool OIDebugger::functionPatch(const prequest& req) {
 
   /* 3. Finish building the trapInfo with the info collected above */
 
-  /* Re-use remoteIov to write the original instructions in our textSegment */
-  remoteIov.clear();
+  /* Collect the writes of the original instructions in our textSegment */
+  RemoteWriteBatch replayWrites{traceePid};
 
   for (auto& trap : tiVec) {
     trap->patchedText = trap->origText;
@@ -1461,8 +1462,8 @@ bool OIDebugger::functionPatch(const prequest& req) {
     }
 
     trap->replayInstAddr = *replayInstrAddr;
-    remoteIov.push_back(
-        {(void*)trap->replayInstAddr, sizeof(trap->origTextBytes)});
+    replayWrites.add(trap->origTextBytes, trap->replayInstAddr,
+                     sizeof(trap->origTextBytes));
 
     if (trap->trapKind == OID_TRAP_VECT_ENTRY ||
         trap->trapKind == OID_TRAP_VECT_ENTRYRET) {
@@ -1487,18 +1488,8 @@ bool OIDebugger::functionPatch(const prequest& req) {
   }
 
   /* 4. Save the original instructions in our Replay Instruction buffer */
-  errno = 0;
-  auto writtenBytes =
-      process_vm_writev(traceePid, localIov.data(), localIov.size(),
-                        remoteIov.data(), remoteIov.size(), 0);
-  if (writtenBytes < 0) {
-    LOG(ERROR) << "Failed to save original instructions: " << strerror(errno);
-    return false;
-  }
-
-  if ((size_t)writtenBytes !=
-      (tiVec.size() * sizeof(trapInfo::origTextBytes))) {
-    LOG(ERROR) << "Failed to save all original instructions!";
+  if (!replayWrites.flush()) {
+    LOG(ERROR) << "Failed to save original instructions";
     return false;
   }
 
@@ -1867,9 +1858,21 @@ OIDebugger::OIDebugger(pid_t pid,
                        const OICodeGen::Config& genConfig,
                        OICompiler::Config ccConfig,
                        TreeBuilder::Config tbConfig)
+    : OIDebugger(pid,
+                 std::make_shared<SymbolService>(pid),
+                 genConfig,
+                 std::move(ccConfig),
+                 std::move(tbConfig)) {
+}
+
+OIDebugger::OIDebugger(pid_t pid,
+                       std::shared_ptr<SymbolService> symbolService,
+                       const OICodeGen::Config& genConfig,
+                       OICompiler::Config ccConfig,
+                       TreeBuilder::Config tbConfig)
     : OIDebugger(genConfig, std::move(ccConfig), std::move(tbConfig)) {
   traceePid = pid;
-  symbols = std::make_shared<SymbolService>(traceePid);
+  symbols = std::move(symbolService);
   setDataSegmentSize(dataSegSize);
   createSegmentConfigFile();
   cache.symbols = symbols;
@@ -1933,6 +1936,11 @@ bool OIDebugger::writeTargetMemory(void* local_buffer,
  * Copy remote buffer from specified address in the target process into
  * the local address.
  *
+ * Large buffers are split into chunks of at most `readChunkSize` bytes, which
+ * are scattered over as many iovecs as the kernel accepts in a single
+ * process_vm_readv() call. Partial transfers are resumed from where the
+ * previous call stopped.
+ *
  * @param[in] remote_buffer - buffer in the target process where the data is
  * read from
  * @param[in] local_addr - local address where new data are to be written
@@ -1944,30 +1952,42 @@ bool OIDebugger::readTargetMemory(void* remote_buffer,
   VLOG(1) << "Reading buffer " << std::hex << remote_buffer << ", bufsz "
           << std::dec << bufsz << " into local " << std::hex << local_addr;
 
-  struct iovec liovecs[] = {{
-      .iov_base = local_addr,
-      .iov_len = bufsz,
-  }};
-  size_t liovcnt = sizeof(liovecs) / sizeof(struct iovec);
+  auto* remote = static_cast<std::byte*>(remote_buffer);
+  auto* local = static_cast<std::byte*>(local_addr);
 
-  struct iovec riovecs[] = {{
-      .iov_base = remote_buffer,
-      .iov_len = bufsz,
-  }};
-  size_t riovcnt = sizeof(riovecs) / sizeof(struct iovec);
+  std::vector<struct iovec> liovecs;
+  std::vector<struct iovec> riovecs;
 
-  auto readBytesCount =
-      process_vm_readv(traceePid, liovecs, liovcnt, riovecs, riovcnt, 0);
-  if (readBytesCount == -1) {
-    LOG(ERROR) << "process_vm_readv() error: " << strerror(errno) << " ("
-               << errno << ")";
-    return false;
-  }
+  size_t readBytes = 0;
+  while (readBytes < bufsz) {
+    liovecs.clear();
+    riovecs.clear();
 
-  if (static_cast<size_t>(readBytesCount) != bufsz) {
-    LOG(ERROR) << "process_vm_readv() wrote only " << readBytesCount
-               << " bytes, expected " << bufsz << " bytes";
-    return false;
+    constexpr size_t maxIovecs = IOV_MAX;
+    size_t off = readBytes;
+    while (off < bufsz && liovecs.size() < maxIovecs) {
+      size_t len = std::min(readChunkSize, bufsz - off);
+      liovecs.push_back({.iov_base = local + off, .iov_len = len});
+      riovecs.push_back({.iov_base = remote + off, .iov_len = len});
+      off += len;
+    }
+
+    auto readBytesCount =
+        process_vm_readv(traceePid, liovecs.data(), liovecs.size(),
+                         riovecs.data(), riovecs.size(), 0);
+    if (readBytesCount == -1) {
+      LOG(ERROR) << "process_vm_readv() error: " << strerror(errno) << " ("
+                 << errno << ")";
+      return false;
+    }
+
+    if (readBytesCount == 0) {
+      LOG(ERROR) << "process_vm_readv() read only " << readBytes
+                 << " bytes, expected " << bufsz << " bytes";
+      return false;
+    }
+
+    readBytes += static_cast<size_t>(readBytesCount);
   }
 
   return true;
@@ -2057,7 +2077,9 @@ OIDebugger::locateJitCodeStart(
  */
 
 bool OIDebugger::writePrologue(
-    const prequest& preq, const OICompiler::RelocResult::SymTable& jitSymbols) {
+    const prequest& preq,
+    const OICompiler::RelocResult::SymTable& jitSymbols,
+    RemoteWriteBatch& writes) {
   size_t off = 0;
   uint8_t newInsts[prologueLength];
 
@@ -2119,8 +2141,8 @@ bool OIDebugger::writePrologue(
 
   assert(off <= prologueLength);
 
-  return writeTargetMemory(&newInsts, (void*)segConfig.textSegBase,
-                           prologueLength);
+  writes.addCopy(&newInsts, segConfig.textSegBase, prologueLength);
+  return true;
 }
 
 /*
@@ -2134,6 +2156,15 @@ bool OIDebugger::compileCode() {
   OICompiler compiler{symbols, compilerConfig};
   std::set<fs::path> objectFiles{};
 
+  struct CompileJob {
+    irequest req;
+    std::string code;
+    fs::path sourcePath;
+    fs::path objectPath;
+  };
+  std::vector<CompileJob> compileJobs;
+  std::vector<irequest> generatedReqs;
+
   /*
    * Global probes don't have multiple arguments, but calling `getReqForArg(X)`
    * on them still returns the corresponding irequest. We take advantage of that
@@ -2191,10 +2222,11 @@ bool OIDebugger::compileCode() {
       return false;
     }
 
-    bool skipCodeGen = cache.isEnabled() && fs::exists(*objectPath) &&
-                       fs::exists(*typeHierarchyPath) &&
-                       fs::exists(*paddingInfoPath);
-    if (skipCodeGen) {
+    bool skipCodeGen = cache.isEnabled() && fs::exists(*objectPath);
+    if (skipCodeGen && typeInfos->find(req) == end(*typeInfos)) {
+      // Not generated by a previous run against this binary, load from cache
+      skipCodeGen =
+          fs::exists(*typeHierarchyPath) && fs::exists(*paddingInfoPath);
       std::pair<RootInfo, TypeHierarchy> th;
       skipCodeGen =
           skipCodeGen && cache.load(req, OICache::Entity::TypeHierarchy, th);
@@ -2204,11 +2236,13 @@ bool OIDebugger::compileCode() {
           skipCodeGen && cache.load(req, OICache::Entity::PaddingInfo, pad);
 
       if (skipCodeGen) {
-        typeInfos.emplace(req, std::make_tuple(th.first, th.second, pad));
+        typeInfos->emplace(req, std::make_tuple(th.first, th.second, pad));
       }
     }
 
-    if (!skipCodeGen) {
+    if (skipCodeGen) {
+      metrics::Tracing::incrementCounter("probe_cache_hit");
+    } else {
       VLOG(2) << "Compiling probe for '" << req.arg
               << "' into: " << *objectPath;
 
@@ -2218,29 +2252,77 @@ bool OIDebugger::compileCode() {
         return false;
       }
 
-      bool doCompile = !cache.isEnabled() || !fs::exists(*objectPath);
+      // Arguments of the same type share an object, which must only be
+      // compiled once: concurrent jobs would write the same file
+      bool doCompile = (!cache.isEnabled() || !fs::exists(*objectPath)) &&
+                       !objectFiles.contains(*objectPath);
       if (doCompile) {
-        if (!compiler.compile(*code, *sourcePath, *objectPath)) {
-          LOG(ERROR) << "Failed to compile code";
-          return false;
-        }
+        compileJobs.push_back(
+            CompileJob{req, std::move(*code), *sourcePath, *objectPath});
       }
+      generatedReqs.push_back(req);
     }
 
-    if (cache.isEnabled() && !skipCodeGen) {
+    objectFiles.insert(*objectPath);
+  }
+
+  /*
+   * Code generation above goes through drgn and SymbolService, which are not
+   * thread-safe, so it runs serially. Compiling the generated code is
+   * independent for each argument and is by far the slowest step, so the
+   * arguments are compiled concurrently. `compiled` holds chars rather than
+   * bools so that workers can write their own element without a data race.
+   */
+  std::vector<char> compiled(compileJobs.size(), false);
+  std::atomic<size_t> nextJob = 0;
+  auto worker = [&]() {
+    OICompiler workerCompiler{symbols, compilerConfig};
+    for (size_t i = nextJob++; i < compileJobs.size(); i = nextJob++) {
+      const auto& job = compileJobs[i];
+      metrics::Tracing _("compile_" + job.req.arg);
+      compiled[i] =
+          workerCompiler.compile(job.code, job.sourcePath, job.objectPath);
+    }
+  };
+
+  size_t numWorkers = std::min<size_t>(
+      compileJobs.size(), std::max(1U, std::thread::hardware_concurrency()));
+  if (numWorkers <= 1) {
+    worker();
+  } else {
+    VLOG(1) << "Compiling " << compileJobs.size() << " probes with "
+            << numWorkers << " threads";
+    std::vector<std::thread> workers;
+    workers.reserve(numWorkers);
+    for (size_t i = 0; i < numWorkers; i++) {
+      workers.emplace_back(worker);
+    }
+    for (auto& t : workers) {
+      t.join();
+    }
+  }
+
+  for (size_t i = 0; i < compileJobs.size(); i++) {
+    if (!compiled[i]) {
+      LOG(ERROR) << "Failed to compile code for '" << compileJobs[i].req.arg
+                 << "'";
+      return false;
+    }
+  }
+
+  if (cache.isEnabled()) {
+    for (const auto& req : generatedReqs) {
       if (req.type == "global") {
         cache.store(req, OICache::Entity::GlobalDescs, symbols->globalDescs);
       } else {
         cache.store(req, OICache::Entity::FuncDescs, symbols->funcDescs);
       }
 
-      const auto& [rootType, typeHierarchy, paddingInfo] = typeInfos.at(req);
+      const auto& [rootType, typeHierarchy, paddingInfo] = typeInfos->at(req);
       cache.store(req, OICache::Entity::TypeHierarchy,
                   std::make_pair(rootType, typeHierarchy));
       cache.store(req, OICache::Entity::PaddingInfo, paddingInfo);
     }
-
-    objectFiles.insert(*objectPath);
   }
 
   if (traceePid) {  // we attach to a process
@@ -2249,6 +2331,7 @@ bool OIDebugger::compileCode() {
         {"dataSize", segConfig.constStart + 1 * sizeof(uintptr_t)},
         {"cookieValue", segConfig.constStart + 2 * sizeof(uintptr_t)},
         {"logFile", segConfig.constStart + 3 * sizeof(uintptr_t)},
+        {"pointersSize", segConfig.constStart + 4 * sizeof(uintptr_t)},
     };
 
     VLOG(2) << "Relocating...";
@@ -2278,42 +2361,34 @@ bool OIDebugger::compileCode() {
       return false;
     }
 
+    /*
+     * The relocated segments, the synthetic symbols and the prologue are all
+     * written in a single batch, to keep the target stopped for as little
+     * time as possible.
+     */
+    RemoteWriteBatch writes{traceePid};
     for (const auto& [BaseAddr, RelocAddr, Size] : segments) {
-      if (!writeTargetMemory((void*)BaseAddr, (void*)RelocAddr, Size)) {
-        return false;
-      }
-    }
-
-    if (!writeTargetMemory(&segConfig.dataSegBase,
-                           (void*)syntheticSymbols["dataBase"],
-                           sizeof(segConfig.dataSegBase))) {
-      LOG(ERROR) << "Failed to write dataSegBase in probe's dataBase";
-      return false;
-    }
-
-    if (!writeTargetMemory(&dataSegSize, (void*)syntheticSymbols["dataSize"],
-                           sizeof(dataSegSize))) {
-      LOG(ERROR) << "Failed to write dataSegSize in probe's dataSize";
-      return false;
-    }
-
-    if (!writeTargetMemory(&segConfig.cookie,
-                           (void*)syntheticSymbols["cookieValue"],
-                           sizeof(segConfig.cookie))) {
-      LOG(ERROR) << "Failed to write cookie in probe's cookieValue";
-      return false;
+      writes.add((void*)BaseAddr, RelocAddr, Size);
     }
 
     int logFile =
         generatorConfig.features[Feature::JitLogging] ? segConfig.logFile : 0;
-    if (!writeTargetMemory(&logFile, (void*)syntheticSymbols["logFile"],
-                           sizeof(logFile))) {
-      LOG(ERROR) << "Failed to write logFile in probe's cookieValue";
+    writes.addValue(segConfig.dataSegBase, syntheticSymbols["dataBase"]);
+    writes.addValue(dataSegSize, syntheticSymbols["dataSize"]);
+    writes.addValue(segConfig.cookie, syntheticSymbols["cookieValue"]);
+    writes.addValue(logFile, syntheticSymbols["logFile"]);
+    writes.addValue(pointerSetSize, syntheticSymbols["pointersSize"]);
+
+    if (!writePrologue(preq, jitSymbols, writes)) {
+      LOG(ERROR) << "Failed to write prologue";
       return false;
     }
 
-    if (!writePrologue(preq, jitSymbols)) {
-      LOG(ERROR) << "Failed to write prologue";
+    metrics::Tracing writeTracing("write_jit_code");
+    VLOG(1) << "Writing " << writes.size() << " buffers (" << writes.bytes()
+            << " bytes) into the target";
+    if (!writes.flush()) {
+      LOG(ERROR) << "Failed to write JIT code and symbols into the target";
       return false;
     }
   }
@@ -2673,81 +2748,64 @@ void OIDebugger::setDataSegmentSize(size_t size) {
   VLOG(1) << "setDataSegmentSize: segment size: " << dataSegSize;
 }
 
-bool OIDebugger::decodeTargetData(const DataHeader& dataHeader,
-                                  std::vector<uint64_t>& outVec) const {
+std::optional<DataSegmentCursor> OIDebugger::decodeTargetData(
+    const DataHeader& dataHeader, size_t availableSize) const {
   VLOG(1) << "== magicId: " << std::hex << dataHeader.magicId;
   VLOG(1) << "== cookie: " << std::hex << dataHeader.cookie;
   VLOG(1) << "== size: " << dataHeader.size;
 
   if (dataHeader.magicId != oidMagicId) {
     LOG(ERROR) << "Got a wrong magic ID: " << std::hex << dataHeader.magicId;
-    return false;
+    return std::nullopt;
   }
 
   if (dataHeader.cookie != segConfig.cookie) {
     LOG(ERROR) << "Got a wrong cookie: " << std::hex << dataHeader.cookie;
-    return false;
+    return std::nullopt;
   }
 
   VLOG(1) << "Total bytes in data segment " << dataHeader.size;
   if (dataHeader.size == 0) {
     LOG(ERROR)
         << "Data segment is empty. Something went wrong while probing...";
-    return false;
+    return std::nullopt;
   }
 
-  if (dataSegSize < dataHeader.size) {
+  if (dataHeader.size < sizeof(dataHeader)) {
+    LOG(ERROR) << "Invalid data size: " << dataHeader.size
+               << " bytes is smaller than the data header";
+    return std::nullopt;
+  }
+
+  if (availableSize < dataHeader.size) {
     LOG(ERROR) << "Error: Data segment is too small. Needed: "
-               << dataHeader.size << " bytes, dataseg size " << dataSegSize
-               << " bytes";
-    return false;
+               << dataHeader.size << " bytes, available " << availableSize
+               << " bytes, dataseg size " << dataSegSize << " bytes";
+    return std::nullopt;
   }
 
   if (generatorConfig.features[Feature::JitTiming]) {
     LOG(INFO) << "JIT Timing: " << dataHeader.timeTakenNs << "ns";
   }
 
-  /*
-   * Currently  we use MAX_INT to indicate two things:
-   *  - a single MAX_INT indicates the end of results for  the current object
-   *  - two consecutive MAX_INT's indicate we have finished completely.
-   */
-  folly::ByteRange range(dataHeader.data, dataHeader.size - sizeof(dataHeader));
-
-  outVec.push_back(0);
-  outVec.push_back(0);
-  outVec.push_back(0);
-  outVec.push_back(0);
-  uint64_t prevVal = 0;
-
-  while (true) {
-    /* XXX Sort out the sentinel value!!! */
-    auto expected = tryDecodeVarint(range);
-    if (!expected) {
-      std::string s =
-          (expected.error() == folly::DecodeVarintError::TooManyBytes)
-              ? "Invalid varint value: too many bytes."
-              : "Invalid varint value: too few bytes.";
-      LOG(ERROR) << s;
-      return false;
-    }
-    uint64_t currVal = expected.value();
-
-    if (currVal == 123456789) {
-      if (prevVal == 123456789) {
-        break;
-      }
-    } else {
-      outVec.push_back(currVal);
-    }
-    prevVal = currVal;
+  VLOG(1) << "Pointer set: " << dataHeader.pointerSetEntries << " entries, "
+          << dataHeader.pointerSetCapacity << " slots, longest probe "
+          << dataHeader.pointerSetMaxProbe;
+  if (dataHeader.pointerSetOverflows > 0) {
+    LOG(WARNING) << "Pointer set could not grow: "
+                 << dataHeader.pointerSetOverflows
+                 << " pointers were not followed";
   }
 
-  return true;
+  /*
+   * The values are not decoded here: the returned cursor decodes them lazily,
+   * straight from the data segment, as TreeBuilder consumes them.
+   */
+  return DataSegmentCursor{std::span<const uint8_t>{
+      dataHeader.data, dataHeader.size - sizeof(dataHeader)}};
 }
 
-static bool dumpDataSegment(const irequest& req,
-                            const std::vector<uint64_t>& dataSeg) {
+static bool dumpDataSegment(const irequest& req, DataSegmentCursor dataSeg) {
   char dumpPath[PATH_MAX] = {0};
   auto dumpPathSize =
       snprintf(dumpPath, sizeof(dumpPath), "/tmp/dataseg.%d.%s.dump", getpid(),
@@ -2764,8 +2822,24 @@ static bool dumpDataSegment(const irequest& req,
     return false;
   }
 
-  const auto outVecBytes = std::as_bytes(std::span{dataSeg});
-  dumpFile.write((const char*)outVecBytes.data(), outVecBytes.size());
+  auto writeValue = [&dumpFile](uint64_t val) {
+    dumpFile.write((const char*)&val, sizeof(val));
+  };
+
+  // Keep the 4 leading dummy 0s expected by `oitb`
+  for (int i = 0; i < 4; i++) {
+    writeValue(0);
+  }
+
+  try {
+    while (auto val = dataSeg.next()) {
+      writeValue(*val);
+    }
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "Data-segment dump for '" << req.arg
+               << "' is truncated: " << e.what();
+  }
+
   if (!dumpFile) {
     LOG(ERROR) << "Failed to write to data-segment file '" << dumpPath
                << "': " << strerror(errno);
@@ -2775,24 +2849,45 @@ static bool dumpDataSegment(const irequest& req,
   return true;
 }
 
-bool OIDebugger::processTargetData() {
-  metrics::Tracing _("process_target_data");
+/*
+ * Walk the chain of DataHeaders written by the JIT code, one per argument, and
+ * return the number of bytes of the data segment that were actually used.
+ * Only the headers are read from the target process. A header with an invalid
+ * size ends the walk: it is still counted so `decodeTargetData` can report
+ * the error.
+ */
+std::optional<size_t> OIDebugger::getTargetDataSize(size_t argCount) const {
+  size_t usedSize = 0;
+  for (size_t i = 0; i < argCount; i++) {
+    if (dataSegSize - usedSize < sizeof(DataHeader)) {
+      break;
+    }
 
-  std::vector<std::byte> buf{dataSegSize};
-  if (!readTargetMemory(reinterpret_cast<void*>(segConfig.dataSegBase),
-                        buf.data(), dataSegSize)) {
-    LOG(ERROR) << "Failed to read data segment from target process";
-    return false;
+    DataHeader dataHeader;
+    if (!readTargetMemory(
+            reinterpret_cast<void*>(segConfig.dataSegBase + usedSize),
+            &dataHeader, sizeof(dataHeader))) {
+      return std::nullopt;
+    }
+
+    if (dataHeader.size < sizeof(dataHeader) ||
+        dataHeader.size > dataSegSize - usedSize) {
+      usedSize += sizeof(dataHeader);
+      break;
+    }
+
+    usedSize += dataHeader.size;
   }
 
-  auto res = reinterpret_cast<uintptr_t>(buf.data());
+  return usedSize;
+}
+
+bool OIDebugger::processTargetData() {
+  metrics::Tracing _("process_target_data");
 
   assert(pdata.numReqs() == 1);
   const auto& preq = pdata.getReq();
 
-  PaddingHunter paddingHunter{};
-  TreeBuilder typeTree(treeBuilderConfig);
-
   /*
    * Global probes don't have multiple arguments, but calling `getReqForArg(X)`
    * on them still returns the corresponding irequest. We take advantage of that
@@ -2801,28 +2896,60 @@ bool OIDebugger::processTargetData() {
    */
   size_t argCount = preq.type == "global" ? 1 : preq.args.size();
 
-  std::vector<uint64_t> outVec{};
+  std::vector<std::byte> buf;
+  {
+    metrics::Tracing readTargetData("read_target_data");
+
+    auto usedSize = getTargetDataSize(argCount);
+    if (!usedSize.has_value()) {
+      LOG(ERROR) << "Failed to read data headers from target process";
+      return false;
+    }
+
+    VLOG(1) << "Reading " << *usedSize << " bytes out of " << dataSegSize
+            << " bytes of data segment";
+
+    buf.resize(*usedSize);
+    if (!readTargetMemory(reinterpret_cast<void*>(segConfig.dataSegBase),
+                          buf.data(), buf.size())) {
+      LOG(ERROR) << "Failed to read data segment from target process";
+      return false;
+    }
+  }
+
+  auto res = reinterpret_cast<uintptr_t>(buf.data());
+  auto resEnd = res + buf.size();
+
+  PaddingHunter paddingHunter{};
+  TreeBuilder typeTree(treeBuilderConfig);
+
   for (size_t i = 0; i < argCount; i++) {
     const auto& req = preq.getReqForArg(i);
     LOG(INFO) << "Processing data for argument: " << req.arg;
 
+    if (resEnd - res < sizeof(DataHeader)) {
+      LOG(ERROR) << "No data in data segment for arg: " << req.arg;
+      return false;
+    }
+
     const auto& dataHeader = *reinterpret_cast<DataHeader*>(res);
+    size_t availableSize = resEnd - res;
     res += dataHeader.size;
 
-    outVec.clear();
-    if (!decodeTargetData(dataHeader, outVec)) {
+    auto dataSeg = decodeTargetData(dataHeader, availableSize);
+    if (!dataSeg.has_value()) {
       LOG(ERROR) << "Failed to decode target data for arg: " << req.arg;
       return false;
     }
 
     if (treeBuilderConfig.dumpDataSegment) {
-      if (!dumpDataSegment(req, outVec)) {
+      if (!dumpDataSegment(req, *dataSeg)) {
         LOG(ERROR) << "Failed to dump data-segment for " << req.arg;
       }
     }
 
-    auto typeInfo = typeInfos.find(req);
-    if (typeInfo == end(typeInfos)) {
+    auto typeInfo = typeInfos->find(req);
+    if (typeInfo == end(*typeInfos)) {
       LOG(ERROR) << "Failed to find corresponding typeInfo for arg: "
                  << req.arg;
       return false;
@@ -2837,7 +2964,7 @@ bool OIDebugger::processTargetData() {
     }
 
     try {
-      typeTree.build(outVec, rootType.varName, rootType.type.type,
+      typeTree.build(*dataSeg, rootType.varName, rootType.type.type,
                      typeHierarchy);
     } catch (std::exception& e) {
       LOG(ERROR) << "Failed to run TreeBuilder for " << req.arg;
@@ -2847,7 +2974,7 @@ bool OIDebugger::processTargetData() {
         LOG(ERROR) << "Data-segment has been dumped for " << req.arg;
       } else {
         LOG(ERROR) << "Dumping data-segment for " << req.arg;
-        if (!dumpDataSegment(req, outVec)) {
+        if (!dumpDataSegment(req, *dataSeg)) {
           LOG(ERROR) << "Failed to dump data-segment for " << req.arg;
         }
       }
@@ -2897,7 +3024,7 @@ std::optional<std::string> OIDebugger::generateCode(const irequest& req) {
     return std::nullopt;
   }
 
-  typeInfos.emplace(
+  typeInfos->emplace(
       req,
       std::make_tuple(RootInfo{rootInfo.varName, codegen->getRootType()},
                       codegen->getTypeHierarchy(), codegen->getPaddingInfo()));
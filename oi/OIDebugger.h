@@ -20,10 +20,12 @@
 #include <filesystem>
 #include <fstream>
 
+#include "oi/DataSegmentCursor.h"
 #include "oi/OICache.h"
 #include "oi/OICodeGen.h"
 #include "oi/OICompiler.h"
 #include "oi/OIParser.h"
+#include "oi/RemoteWriteBatch.h"
 #include "oi/SymbolService.h"
 #include "oi/TrapInfo.h"
 #include "oi/TreeBuilder.h"
@@ -35,7 +37,20 @@ class OIDebugger {
   OIDebugger(const OICodeGen::Config&, OICompiler::Config, TreeBuilder::Config);
 
  public:
+  using TypeInfos = std::unordered_map<
+      irequest,
+      std::tuple<RootInfo, TypeHierarchy, std::map<std::string, PaddingInfo>>>;
+
+  OIDebugger(pid_t,
+             const OICodeGen::Config&,
+             OICompiler::Config,
+             TreeBuilder::Config);
+  /*
+   * Attach to a process reusing the symbols of a previous run against the
+   * same binary (see SymbolService::retarget).
+   */
   OIDebugger(pid_t,
+             std::shared_ptr<SymbolService>,
              const OICodeGen::Config&,
              OICompiler::Config,
              TreeBuilder::Config);
@@ -51,6 +66,9 @@ class OIDebugger {
   bool processTargetData();
   bool executeCode(pid_t);
   void setDataSegmentSize(size_t);
+  void setPointerSetSize(size_t size) {
+    pointerSetSize = size;
+  }
   void restoreState(void);
   bool segConfigExists(void) const {
     return segConfig.existingConfig;
@@ -84,6 +102,13 @@ class OIDebugger {
       // TODO if returning false here, throw an error
       std::filesystem::create_directory(basePath);
     }
+    if (compilerConfig.objectCacheDir.empty()) {
+      // Objects are content-addressed, they can be shared by all the requests
+      compilerConfig.objectCacheDir = basePath / "objects";
+    }
+    if (compilerConfig.precompiledHeaderDir.empty()) {
+      compilerConfig.precompiledHeaderDir = basePath / "pch";
+    }
     cache.basePath = std::move(basePath);
   }
 
@@ -132,13 +157,22 @@ class OIDebugger {
 
   std::pair<RootInfo, TypeHierarchy> getTreeBuilderTyping() {
     assert(pdata.numReqs() == 1);
-    auto [type, th, _] = typeInfos.at(pdata.getReq().getReqForArg());
+    auto [type, th, _] = typeInfos->at(pdata.getReq().getReqForArg());
     return {type, th};
   };
 
   std::map<std::string, PaddingInfo> getPaddingInfo() {
     assert(pdata.numReqs() == 1);
-    return std::get<2>(typeInfos.at(pdata.getReq().getReqForArg()));
+    return std::get<2>(typeInfos->at(pdata.getReq().getReqForArg()));
+  }
+
+  /*
+   * Share the type information of the generated probes with other
+   * OIDebuggers working on the same binary, so they can skip code generation
+   * for probes that have already been compiled.
+   */
+  void setTypeInfos(std::shared_ptr<TypeInfos> infos) {
+    typeInfos = std::move(infos);
   }
 
   void setCustomCodeFile(std::filesystem::path newCCT) {
@@ -165,6 +199,8 @@ class OIDebugger {
   static OIDebugger::StatusType getTaskState(pid_t pid);
   static std::string taskStateToString(OIDebugger::StatusType);
   size_t dataSegSize{1 << 20};
+  /* Initial size of the JIT code's pointer set, which grows as needed */
+  size_t pointerSetSize{1 << 20};
   size_t textSegSize{(1 << 22) + (1 << 20)};
   std::vector<pid_t> threadList;
   ParseData pdata{};
@@ -187,10 +223,7 @@ class OIDebugger {
   std::unordered_map<pid_t, std::shared_ptr<trapInfo>> threadTrapState;
   std::unordered_map<uintptr_t, uintptr_t> replayInstMap;
 
-  std::unordered_map<
-      irequest,
-      std::tuple<RootInfo, TypeHierarchy, std::map<std::string, PaddingInfo>>>
-      typeInfos;
+  std::shared_ptr<TypeInfos> typeInfos = std::make_shared<TypeInfos>();
 
   template <typename Sys, typename... Args>
   std::optional<typename Sys::RetType> remoteSyscall(Args...);
@@ -210,7 +243,9 @@ class OIDebugger {
   bool readTargetMemory(void*, void*, size_t) const;
   std::optional<std::pair<OIDebugger::ObjectAddrMap::key_type, uintptr_t>>
   locateJitCodeStart(const irequest&, const OICompiler::RelocResult::SymTable&);
-  bool writePrologue(const prequest&, const OICompiler::RelocResult::SymTable&);
+  bool writePrologue(const prequest&,
+                     const OICompiler::RelocResult::SymTable&,
+                     RemoteWriteBatch&);
   bool readInstFromTarget(uintptr_t, uint8_t*, size_t);
   void createSegmentConfigFile(void);
   void deleteSegmentConfig(bool);
@@ -268,12 +303,19 @@ class OIDebugger {
    *      an older run.
    *  3. The size of the data segment as written by the JIT-ed
    *      code.
+   *  4. The time taken by the JIT-ed code, with the JitTiming feature.
+   *  5. Occupancy and probe-length statistics of the JIT-ed code's
+   *      pointer-deduplication set.
    */
   struct DataHeader {
     uintptr_t magicId;
     uintptr_t cookie;
     uintptr_t size;
     uintptr_t timeTakenNs;
+    uintptr_t pointerSetEntries;
+    uintptr_t pointerSetCapacity;
+    uintptr_t pointerSetMaxProbe;
+    uintptr_t pointerSetOverflows;
 
     /*
      * Flexible Array Member are not standard in C++, but this is
@@ -281,7 +323,7 @@ class OIDebugger {
      * disable the pedantic warnings, so the compiler stops yelling at us.
      * We want the header to be the size of the fields above. This is
      * important for the `decodeTargetData` method, to give the right size
-     * to `folly::ByteRange range(…)`.
+     * to the `DataSegmentCursor` it returns.
      */
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wpedantic"
@@ -289,7 +331,15 @@ class OIDebugger {
 #pragma GCC diagnostic pop
   };
 
-  bool decodeTargetData(const DataHeader&, std::vector<uint64_t>&) const;
+  std::optional<size_t> getTargetDataSize(size_t) const;
+  std::optional<DataSegmentCursor> decodeTargetData(const DataHeader&,
+                                                    size_t) const;
+
+  /*
+   * Maximum number of bytes transferred by a single iovec when reading from
+   * the target process. See `readTargetMemory`.
+   */
+  static constexpr size_t readChunkSize = 1 << 22;
 
   static constexpr size_t prologueLength = 64;
   static constexpr size_t constLength = 64;
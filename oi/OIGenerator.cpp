@@ -18,12 +18,16 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <atomic>
 #include <boost/core/demangle.hpp>
 #include <fstream>
 #include <iostream>
 #include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <variant>
+#include <vector>
 
 #include "oi/CodeGen.h"
 #include "oi/DrgnUtils.h"
@@ -132,31 +136,44 @@ fs::path OIGenerator::generateForType(const OICodeGen::Config& generatorConfig,
                                       const OICompiler::Config& compilerConfig,
                                       const drgn_qualified_type& type,
                                       const std::string& linkageName,
-                                      SymbolService& symbols) {
-  CodeGen codegen{generatorConfig, symbols};
+                                      SymbolService& symbols,
+                                      std::mutex& codegenMutex) {
+  auto linkageNameHash = std::to_string(std::hash<std::string>{}(linkageName));
 
   std::string code;
-  if (!codegen.codegenFromDrgn(type.type, linkageName, code)) {
-    LOG(ERROR) << "codegen failed!";
-    return {};
-  }
+  fs::path sourcePath;
+  {
+    /*
+     * Neither drgn nor SymbolService are thread-safe, so code generation is
+     * serialised. Only the compilation below runs concurrently.
+     */
+    std::lock_guard<std::mutex> lock{codegenMutex};
+    CodeGen codegen{generatorConfig, symbols};
+
+    if (!codegen.codegenFromDrgn(type.type, linkageName, code)) {
+      LOG(ERROR) << "codegen failed!";
+      return {};
+    }
 
-  std::string sourcePath = sourceFileDumpPath;
-  if (sourceFileDumpPath.empty()) {
-    // This is the path Clang acts as if it has compiled from e.g. for debug
-    // information. It does not need to exist.
-    sourcePath = "oil_jit.cpp";
-  } else {
-    std::ofstream outputFile(sourcePath);
-    outputFile << code;
+    if (sourceFileDumpPath.empty()) {
+      // This is the path Clang acts as if it has compiled from e.g. for debug
+      // information. It does not need to exist.
+      sourcePath = "oil_jit.cpp";
+    } else {
+      // Each type gets its own file, which its debug information refers to
+      sourcePath = sourceFileDumpPath;
+      sourcePath.replace_extension("." + linkageNameHash +
+                                   sourceFileDumpPath.extension().string());
+      std::ofstream outputFile(sourcePath);
+      outputFile << code;
+    }
   }
 
   OICompiler compiler{{}, compilerConfig};
 
   // TODO: Revert to outputPath and remove printing when typegraph is done.
   fs::path tmpObject = outputPath;
-  tmpObject.replace_extension(
-      "." + std::to_string(std::hash<std::string>{}(linkageName)) + ".o");
+  tmpObject.replace_extension("." + linkageNameHash + ".o");
 
   if (!compiler.compile(code, sourcePath, tmpObject)) {
     return {};
@@ -202,14 +219,49 @@ int OIGenerator::generate(fs::path& primaryObject, SymbolService& symbols) {
   generatorConfig.features = *features;
   compilerConfig.features = *features;
 
+  /*
+   * Sort the types by linkage name so the list of objects printed is the same
+   * regardless of the hash map's iteration order or of which worker finishes
+   * first.
+   */
+  std::vector<std::pair<std::string, drgn_qualified_type>> sortedTypes{
+      oilTypes.begin(), oilTypes.end()};
+  std::sort(sortedTypes.begin(), sortedTypes.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+
+  std::vector<fs::path> objects(sortedTypes.size());
+  std::mutex codegenMutex;
+  std::atomic<size_t> nextType = 0;
+  auto worker = [&]() {
+    for (size_t i = nextType++; i < sortedTypes.size(); i = nextType++) {
+      const auto& [linkageName, type] = sortedTypes[i];
+      objects[i] = generateForType(generatorConfig, compilerConfig, type,
+                                   linkageName, symbols, codegenMutex);
+    }
+  };
+
+  size_t numWorkers = std::min(jobs, sortedTypes.size());
+  if (numWorkers <= 1) {
+    worker();
+  } else {
+    LOG(INFO) << "generating " << sortedTypes.size() << " types with "
+              << numWorkers << " jobs";
+    std::vector<std::thread> workers;
+    workers.reserve(numWorkers);
+    for (size_t i = 0; i < numWorkers; i++) {
+      workers.emplace_back(worker);
+    }
+    for (auto& t : workers) {
+      t.join();
+    }
+  }
+
   size_t failures = 0;
-  for (const auto& [linkageName, type] : oilTypes) {
-    if (auto obj = generateForType(generatorConfig, compilerConfig, type,
-                                   linkageName, symbols);
-        !obj.empty()) {
-      std::cout << obj.string() << std::endl;
+  for (size_t i = 0; i < sortedTypes.size(); i++) {
+    if (!objects[i].empty()) {
+      std::cout << objects[i].string() << std::endl;
     } else {
-      LOG(WARNING) << "failed to generate for symbol `" << linkageName
+      LOG(WARNING) << "failed to generate for symbol `" << sortedTypes[i].first
                    << "`. this is non-fatal but the call will not work.";
       failures++;
     }
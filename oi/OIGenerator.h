@@ -16,7 +16,9 @@
 
 #pragma once
 
+#include <cstddef>
 #include <filesystem>
+#include <mutex>
 
 #include "oi/DrgnUtils.h"
 #include "oi/OICodeGen.h"
@@ -43,6 +45,9 @@ class OIGenerator {
   void setUsePIC(bool pic_) {
     pic = pic_;
   }
+  void setJobs(size_t jobs_) {
+    jobs = jobs_ == 0 ? 1 : jobs_;
+  }
 
  private:
   std::filesystem::path outputPath;
@@ -50,6 +55,7 @@ class OIGenerator {
   std::filesystem::path sourceFileDumpPath;
   bool failIfNothingGenerated = false;
   bool pic = false;
+  size_t jobs = 1;
 
   std::unordered_map<std::string, std::string> oilStrongToWeakSymbolsMap(
       drgnplusplus::program& prog);
@@ -62,7 +68,8 @@ class OIGenerator {
       const OICompiler::Config& compilerConfig,
       const drgn_qualified_type& type,
       const std::string& linkageName,
-      SymbolService& symbols);
+      SymbolService& symbols,
+      std::mutex& codegenMutex);
 };
 
 }  // namespace oi::detail
@@ -15,6 +15,7 @@
  */
 #include "OILibraryImpl.h"
 
+#include <dlfcn.h>
 #include <glog/logging.h>
 #include <sys/mman.h>
 
@@ -23,6 +24,7 @@
 #include <cerrno>
 #include <cstring>
 #include <fstream>
+#include <iterator>
 #include <stdexcept>
 
 #include "oi/DrgnUtils.h"
@@ -101,36 +103,31 @@ void OILibraryImpl::processConfigFile() {
 
   generatorConfig_.features = *features;
   compilerConfig_.features = *features;
+
+  if (opts_.optimizationLevel) {
+    if (*opts_.optimizationLevel < 0 || *opts_.optimizationLevel > 3)
+      throw std::invalid_argument("optimization level must be between 0 and 3");
+    compilerConfig_.optimizationLevel = *opts_.optimizationLevel;
+  }
 }
 
 std::pair<void*, const exporters::inst::Inst&> OILibraryImpl::compileCode() {
   google::SetVLOGLevel("*", opts_.debugLevel);
 
   auto symbols = std::make_shared<SymbolService>(getpid());
-
-  auto* prog = symbols->getDrgnProgram();
-  CHECK(prog != nullptr) << "does this check need to exist?";
-
-  auto rootType = getTypeFromAtomicHole(symbols->getDrgnProgram(), atomicHole_);
-
-  CodeGen codegen{generatorConfig_, *symbols};
-
-  std::string code;
-  if (!codegen.codegenFromDrgn(rootType.type, code))
-    throw std::runtime_error("oil jit codegen failed!");
-
-  std::string sourcePath = opts_.sourceFileDumpPath;
-  if (sourcePath.empty()) {
-    sourcePath = "oil_jit.cpp";  // fake path for JIT debug info
-  } else {
-    std::ofstream outputFile(sourcePath);
-    outputFile << code;
-  }
+  OICompiler compiler{symbols, compilerConfig_};
 
   auto object = MemoryFile("oil_object_code");
-  OICompiler compiler{symbols, compilerConfig_};
-  if (!compiler.compile(code, sourcePath, object.path()))
-    throw std::runtime_error("oil jit compilation failed!");
+  auto registryEntry = getRegistryEntry(*symbols);
+
+  std::optional<std::string> nameHash;
+  if (registryEntry)
+    nameHash = loadFromRegistry(*registryEntry, object.path());
+  if (!nameHash) {
+    nameHash = generateObject(*symbols, compiler, object.path());
+    if (registryEntry)
+      storeInRegistry(*registryEntry, object.path(), *nameHash);
+  }
 
   auto relocRes = compiler.applyRelocs(
       reinterpret_cast<uint64_t>(textSeg.data().data()), {object.path()}, {});
@@ -139,12 +136,8 @@ std::pair<void*, const exporters::inst::Inst&> OILibraryImpl::compileCode() {
 
   const auto& [_, segments, jitSymbols] = *relocRes;
 
-  std::string nameHash =
-      (boost::format("%1$016x") %
-       std::hash<std::string>{}(SymbolService::getTypeName(rootType.type)))
-          .str();
-  std::string functionSymbolPrefix = "_Z27introspect_" + nameHash;
-  std::string typeSymbolName = "treeBuilderInstructions" + nameHash;
+  std::string functionSymbolPrefix = "_Z27introspect_" + *nameHash;
+  std::string typeSymbolName = "treeBuilderInstructions" + *nameHash;
   void* fp = nullptr;
   const exporters::inst::Inst* ty = nullptr;
   for (const auto& [symName, symAddr] : jitSymbols) {
@@ -170,6 +163,157 @@ std::pair<void*, const exporters::inst::Inst&> OILibraryImpl::compileCode() {
   return {fp, *ty};
 }
 
+/*
+ * Generate and compile the introspection code for the root type into
+ * @param objectPath. Returns the hash of the root type's name that suffixes
+ * the generated symbols.
+ */
+std::string OILibraryImpl::generateObject(
+    SymbolService& symbols,
+    OICompiler& compiler,
+    const std::filesystem::path& objectPath) {
+  auto* prog = symbols.getDrgnProgram();
+  CHECK(prog != nullptr) << "does this check need to exist?";
+
+  auto rootType = getTypeFromAtomicHole(prog, atomicHole_);
+
+  CodeGen codegen{generatorConfig_, symbols};
+
+  std::string code;
+  if (!codegen.codegenFromDrgn(rootType.type, code))
+    throw std::runtime_error("oil jit codegen failed!");
+
+  std::string sourcePath = opts_.sourceFileDumpPath;
+  if (sourcePath.empty()) {
+    sourcePath = "oil_jit.cpp";  // fake path for JIT debug info
+  } else {
+    std::ofstream outputFile(sourcePath);
+    outputFile << code;
+  }
+
+  if (!compiler.compile(code, sourcePath, objectPath))
+    throw std::runtime_error("oil jit compilation failed!");
+
+  return (boost::format("%1$016x") %
+          std::hash<std::string>{}(SymbolService::getTypeName(rootType.type)))
+      .str();
+}
+
+/*
+ * The registry entry of this introspection function, without extension.
+ *
+ * The atomic hole is a static variable unique to each CodegenHandler<T, Fs...>
+ * instantiation, so its offset in the loaded object identifies the type and
+ * the features without having to look at the debug info. The build ID of the
+ * object holding it, which is a shared library when OIL is used from one,
+ * ties that offset to a specific build. The container definitions are part of
+ * the key too, as the generated code depends on their contents.
+ */
+std::optional<std::filesystem::path> OILibraryImpl::getRegistryEntry(
+    SymbolService& symbols) {
+  if (opts_.registryPath.empty())
+    return std::nullopt;
+
+  Dl_info info{};
+  if (dladdr(atomicHole_, &info) == 0 || info.dli_fbase == nullptr) {
+    LOG(WARNING) << "failed to find the object containing the atomic hole, "
+                    "not using the registry";
+    return std::nullopt;
+  }
+  auto holeOffset = reinterpret_cast<uintptr_t>(atomicHole_) -
+                    reinterpret_cast<uintptr_t>(info.dli_fbase);
+
+  auto buildID =
+      symbols.locateBuildID(reinterpret_cast<uintptr_t>(atomicHole_));
+  if (!buildID) {
+    LOG(WARNING) << "failed to locate the build ID of " << info.dli_fname
+                 << ", not using the registry";
+    return std::nullopt;
+  }
+
+  std::string key = *buildID + "/" + std::to_string(holeOffset) + "/" +
+                    generatorConfig_.toString() + "/O" +
+                    std::to_string(compilerConfig_.optimizationLevel);
+  for (const auto& path : generatorConfig_.containerConfigPaths) {
+    std::ifstream file{path};
+    if (!file) {
+      LOG(WARNING) << "failed to read " << path << ", not using the registry";
+      return std::nullopt;
+    }
+    key += "/";
+    key.append(std::istreambuf_iterator<char>{file},
+               std::istreambuf_iterator<char>{});
+  }
+  return opts_.registryPath /
+         (boost::format("%1%-%2$016x") % *buildID %
+          std::hash<std::string>{}(key))
+             .str();
+}
+
+/*
+ * Copy the registry's object into @param object. Returns the root type's name
+ * hash stored alongside it, or std::nullopt if the entry is absent or unusable.
+ */
+std::optional<std::string> OILibraryImpl::loadFromRegistry(
+    const std::filesystem::path& entry, const std::filesystem::path& object) {
+  auto objectPath = entry;
+  objectPath += ".o";
+  auto symPath = entry;
+  symPath += ".sym";
+
+  // The .sym file is written last, its presence marks a complete entry
+  std::ifstream symFile{symPath};
+  std::string nameHash;
+  if (!(symFile >> nameHash))
+    return std::nullopt;
+
+  std::error_code ec;
+  std::filesystem::copy_file(
+      objectPath, object, std::filesystem::copy_options::overwrite_existing,
+      ec);
+  if (ec) {
+    LOG(WARNING) << "failed to load " << objectPath
+                 << " from the registry: " << ec.message();
+    return std::nullopt;
+  }
+
+  VLOG(1) << "loaded introspection function from " << objectPath;
+  return nameHash;
+}
+
+void OILibraryImpl::storeInRegistry(const std::filesystem::path& entry,
+                                    const std::filesystem::path& object,
+                                    const std::string& nameHash) {
+  auto objectPath = entry;
+  objectPath += ".o";
+  auto symPath = entry;
+  symPath += ".sym";
+
+  // Write through temporary files so concurrent processes never observe a
+  // partial entry.
+  std::error_code ec;
+  std::filesystem::create_directories(opts_.registryPath, ec);
+
+  auto tmpObject = utils::temporaryPath(objectPath);
+  std::filesystem::copy_file(
+      object, tmpObject, std::filesystem::copy_options::overwrite_existing, ec);
+  if (!ec)
+    std::filesystem::rename(tmpObject, objectPath, ec);
+
+  auto tmpSym = utils::temporaryPath(symPath);
+  if (!ec) {
+    std::ofstream{tmpSym} << nameHash << '\n';
+    std::filesystem::rename(tmpSym, symPath, ec);
+  }
+
+  if (ec) {
+    LOG(WARNING) << "failed to store " << entry
+                 << " in the registry: " << ec.message();
+    std::filesystem::remove(tmpObject, ec);
+    std::filesystem::remove(tmpSym, ec);
+  }
+}
+
 namespace {
 std::map<Feature, bool> convertFeatures(std::unordered_set<oi::Feature> fs) {
   std::map<Feature, bool> out{
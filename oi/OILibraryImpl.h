@@ -18,7 +18,9 @@
 
 #include <filesystem>
 #include <map>
+#include <optional>
 #include <span>
+#include <string>
 #include <unordered_set>
 #include <utility>
 
@@ -84,6 +86,16 @@ class OILibraryImpl {
 
   void processConfigFile();
   std::pair<void*, const exporters::inst::Inst&> compileCode();
+  std::string generateObject(SymbolService&,
+                             OICompiler&,
+                             const std::filesystem::path&);
+
+  std::optional<std::filesystem::path> getRegistryEntry(SymbolService&);
+  std::optional<std::string> loadFromRegistry(
+      const std::filesystem::path& entry, const std::filesystem::path& object);
+  void storeInRegistry(const std::filesystem::path& entry,
+                       const std::filesystem::path& object,
+                       const std::string& nameHash);
 };
 
 }  // namespace oi::detail
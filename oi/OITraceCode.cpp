@@ -29,6 +29,7 @@
 
 #include <utility>
 #include <unistd.h>
+#include <sys/mman.h>
 
 // clang-format on
 
@@ -40,10 +41,30 @@ constexpr int oidMagicId = 0x01DE8;
 
 namespace {
 
+// Occupancy and probe-length statistics of the pointer set, reported back to
+// OID in the data segment header.
+struct PointerSetStats {
+  uintptr_t entries;
+  uintptr_t capacity;
+  uintptr_t maxProbe;
+  uintptr_t overflows;
+};
+
+// 1 MiB of pointers unless OID asks for a different initial size
+constexpr size_t pointerSetDefaultSize = 1 << 20;
+constexpr size_t pointerSetMinCapacity = 1 << 10;
+
 class {
  private:
-  // 1 MiB of pointers
-  std::array<uintptr_t, (1 << 20) / sizeof(uintptr_t)> data;
+  // Open-addressed table of pointers, where 0 marks an empty slot. The table
+  // lives in its own anonymous mapping so that it can grow with the number of
+  // unique pointers found instead of being bounded by a fixed size.
+  uintptr_t* data = nullptr;
+  size_t capacity = 0;  // Always a power of two
+  size_t entries = 0;
+  size_t maxProbe = 0;
+  size_t overflows = 0;
+  bool canGrow = true;
 
   // twang_mix64 hash function, taken from Folly where it is used
   // as the default hash function for 64-bit integers
@@ -58,27 +79,112 @@ class {
     return key;
   }
 
+  static uintptr_t* allocate(size_t count) noexcept {
+    // Anonymous mappings are zero-filled, so every slot starts out empty
+    void* mem = mmap(nullptr, count * sizeof(uintptr_t), PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return mem == MAP_FAILED ? nullptr : static_cast<uintptr_t*>(mem);
+  }
+
+  // Doubles the capacity of the table and rehashes every entry. Returns
+  // `false` if the bigger table could not be allocated, in which case the
+  // current table is left untouched.
+  bool grow() noexcept {
+    if (data == nullptr || !canGrow) {
+      return false;
+    }
+
+    size_t newCapacity = capacity * 2;
+    uintptr_t* newData = allocate(newCapacity);
+    if (newData == nullptr) {
+      canGrow = false;
+      return false;
+    }
+
+    size_t mask = newCapacity - 1;
+    maxProbe = 0;
+    for (size_t i = 0; i < capacity; i++) {
+      uintptr_t pointer = data[i];
+      if (pointer == 0) {
+        continue;
+      }
+
+      size_t index = twang_mix64(pointer) & mask;
+      size_t probe = 0;
+      while (newData[index] != 0) {
+        index = (index + 1) & mask;
+        probe++;
+      }
+      newData[index] = pointer;
+      maxProbe = probe > maxProbe ? probe : maxProbe;
+    }
+
+    munmap(data, capacity * sizeof(uintptr_t));
+    data = newData;
+    capacity = newCapacity;
+    return true;
+  }
+
  public:
-  void initialize() noexcept {
-    data.fill(0);
+  // Resets the set before a new traversal. `size` is the initial size of the
+  // table in bytes; the table doubles whenever it becomes 3/4 full.
+  void initialize(size_t size = pointerSetDefaultSize) noexcept {
+    release();
+
+    size_t count = pointerSetMinCapacity;
+    while (count * sizeof(uintptr_t) < size) {
+      count *= 2;
+    }
+
+    data = allocate(count);
+    capacity = data == nullptr ? 0 : count;
+    entries = 0;
+    maxProbe = 0;
+    overflows = 0;
+    canGrow = true;
+  }
+
+  // Unmaps the table. The statistics remain available until the next call to
+  // `initialize`.
+  void release() noexcept {
+    if (data != nullptr) {
+      munmap(data, capacity * sizeof(uintptr_t));
+      data = nullptr;
+    }
+  }
+
+  PointerSetStats stats() const noexcept {
+    return {entries, capacity, maxProbe, overflows};
   }
 
   // Adds the pointer to the set.
   // Returns `true` if the value was newly added,
   // or `false` if the value was already present.
+  //
+  // If the table is full and cannot grow, the pointer is counted as an
+  // overflow and treated as already present, so its pointee is skipped rather
+  // than risking an endless probe or an infinite traversal of a cycle.
   bool add(uintptr_t pointer) noexcept {
     __builtin_assume(pointer > 0);
-    uint64_t index = twang_mix64(pointer) % data.size();
-    while (true) {
+    if (4 * (entries + 1) > 3 * capacity && !grow() && entries == capacity) {
+      overflows++;
+      return false;
+    }
+
+    size_t mask = capacity - 1;
+    size_t index = twang_mix64(pointer) & mask;
+    for (size_t probe = 0;; probe++) {
       uintptr_t entry = data[index];
       if (entry == 0) {
         data[index] = pointer;
+        entries++;
+        maxProbe = probe > maxProbe ? probe : maxProbe;
         return true;
       }
       if (entry == pointer) {
         return false;
       }
-      index = (index + 1) % data.size();
+      index = (index + 1) & mask;
     }
   }
 } static pointers;
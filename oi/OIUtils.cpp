@@ -22,9 +22,15 @@
 #include <boost/property_tree/ini_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <filesystem>
+#include <string>
+#include <thread>
 
 #include "oi/support/Toml.h"
 
+extern "C" {
+#include <unistd.h>
+}
+
 namespace fs = std::filesystem;
 
 namespace oi::detail::utils {
@@ -133,6 +139,22 @@ std::optional<FeatureSet> processConfigFile(
     }
   }
 
+  if (toml::table* compiler = config["compiler"].as_table()) {
+    if (auto* path = (*compiler)["object_cache_path"].as_string()) {
+      compilerConfig.objectCacheDir = configDirectory / path->get();
+    }
+    if (auto* path = (*compiler)["pch_path"].as_string()) {
+      compilerConfig.precompiledHeaderDir = configDirectory / path->get();
+    }
+    if (auto* level = (*compiler)["optimization_level"].as_integer()) {
+      if (level->get() < 0 || level->get() > 3) {
+        LOG(ERROR) << "optimization_level must be between 0 and 3";
+        return {};
+      }
+      compilerConfig.optimizationLevel = static_cast<int>(level->get());
+    }
+  }
+
   if (toml::table* codegen = config["codegen"].as_table()) {
     if (toml::array* arr = (*codegen)["default_headers"].as_array()) {
       arr->for_each([&](auto&& el) {
@@ -184,4 +206,12 @@ std::optional<FeatureSet> processConfigFile(
   return handleFeatureConflicts(enabledFeatures, disabledFeatures);
 }
 
+fs::path temporaryPath(const fs::path& path) {
+  auto tmpPath = path;
+  tmpPath += ".tmp." + std::to_string(getpid()) + "." +
+             std::to_string(std::hash<std::thread::id>{}(
+                 std::this_thread::get_id()));
+  return tmpPath;
+}
+
 }  // namespace oi::detail::utils
@@ -15,6 +15,7 @@
  */
 #pragma once
 
+#include <filesystem>
 #include <optional>
 #include <set>
 
@@ -29,4 +30,10 @@ std::optional<FeatureSet> processConfigFile(const std::string& configFilePath,
                                             OICompiler::Config& compilerConfig,
                                             OICodeGen::Config& generatorConfig);
 
+/*
+ * A temporary path next to @param path, unique to this process and thread, to
+ * write a file before renaming it into place.
+ */
+std::filesystem::path temporaryPath(const std::filesystem::path& path);
+
 }  // namespace oi::detail::utils
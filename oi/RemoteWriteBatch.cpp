@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "oi/RemoteWriteBatch.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#include <glog/logging.h>
+
+namespace oi::detail {
+
+void RemoteWriteBatch::add(const void* local, uintptr_t remote, size_t size) {
+  if (size == 0) {
+    return;
+  }
+
+  localIov_.push_back({const_cast<void*>(local), size});
+  remoteIov_.push_back({reinterpret_cast<void*>(remote), size});
+  bytes_ += size;
+}
+
+void RemoteWriteBatch::addCopy(const void* local,
+                               uintptr_t remote,
+                               size_t size) {
+  const auto* bytes = static_cast<const uint8_t*>(local);
+  const auto& copy = copies_.emplace_back(bytes, bytes + size);
+  add(copy.data(), remote, size);
+}
+
+bool RemoteWriteBatch::flush() {
+  bool success = true;
+
+  for (size_t first = 0; first < localIov_.size(); first += IOV_MAX) {
+    size_t count = std::min<size_t>(IOV_MAX, localIov_.size() - first);
+
+    size_t expected = 0;
+    for (size_t i = first; i < first + count; i++) {
+      expected += localIov_[i].iov_len;
+    }
+
+    VLOG(1) << "Writing " << count << " buffers, " << expected
+            << " bytes, into target";
+
+    errno = 0;
+    auto written = process_vm_writev(pid_, &localIov_[first], count,
+                                     &remoteIov_[first], count, 0);
+    if (written == -1) {
+      LOG(ERROR) << "process_vm_writev() error: " << std::strerror(errno)
+                 << " (" << errno << ")";
+      success = false;
+      break;
+    }
+
+    if (static_cast<size_t>(written) != expected) {
+      LOG(ERROR) << "process_vm_writev() wrote only " << written
+                 << " bytes, expected " << expected << " bytes";
+      success = false;
+      break;
+    }
+  }
+
+  localIov_.clear();
+  remoteIov_.clear();
+  copies_.clear();
+  bytes_ = 0;
+  return success;
+}
+
+}  // namespace oi::detail
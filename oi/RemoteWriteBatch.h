@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+extern "C" {
+#include <sys/types.h>
+#include <sys/uio.h>
+}
+
+namespace oi::detail {
+
+/*
+ * RemoteWriteBatch
+ *
+ * Collects writes into another process' memory and issues them with as few
+ * process_vm_writev(2) calls as possible, each carrying up to IOV_MAX iovecs.
+ * Like process_vm_writev(2) itself, this only works for mappings of the target
+ * which are writable, so it can't be used to patch the target's text.
+ */
+class RemoteWriteBatch {
+ public:
+  explicit RemoteWriteBatch(pid_t pid) : pid_{pid} {
+  }
+
+  /*
+   * Queue a write of `size` bytes from `local` to `remote`. The local buffer
+   * is not copied and must stay valid until `flush` returns.
+   */
+  void add(const void* local, uintptr_t remote, size_t size);
+
+  /*
+   * Queue a write of `size` bytes from `local` to `remote`, copying the local
+   * buffer so that it doesn't need to outlive the call.
+   */
+  void addCopy(const void* local, uintptr_t remote, size_t size);
+
+  template <typename T>
+  void addValue(const T& value, uintptr_t remote) {
+    addCopy(&value, remote, sizeof(value));
+  }
+
+  /*
+   * Write everything queued so far and empty the batch. Returns `false` if
+   * any of the writes failed or was incomplete.
+   */
+  bool flush();
+
+  size_t size() const {
+    return localIov_.size();
+  }
+
+  size_t bytes() const {
+    return bytes_;
+  }
+
+ private:
+  pid_t pid_;
+  std::vector<struct iovec> localIov_;
+  std::vector<struct iovec> remoteIov_;
+  size_t bytes_ = 0;
+
+  /* A deque never moves its elements, so queued iovecs stay valid */
+  std::deque<std::vector<uint8_t>> copies_;
+};
+
+}  // namespace oi::detail
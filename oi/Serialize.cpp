@@ -38,8 +38,8 @@ void verify_version(const unsigned int version) {
   }
 }
 
-using iarchive = boost::archive::text_iarchive;
-using oarchive = boost::archive::text_oarchive;
+using iarchive = oi::detail::CacheIArchive;
+using oarchive = oi::detail::CacheOArchive;
 
 // The default value for `boost::serialization::version` for a class is 0
 // if it is not specified via `BOOST_CLASS_VERSION`. Therefore the
@@ -363,3 +363,30 @@ INSTANCIATE_SERIALIZE(struct TypeHierarchy)
 // INSTANCIATE_SERIALIZE(std::map<struct drgn_type *, struct drgn_type *>)
 
 }  // namespace boost::serialization
+
+namespace oi::detail {
+
+void writeCacheFileHeader(std::ostream& os) {
+  CacheFileHeader header{
+      .magic = cacheFileMagic,
+      .formatVersion = cacheFileFormatVersion,
+  };
+  os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+void readCacheFileHeader(std::istream& is) {
+  CacheFileHeader header{};
+  is.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!is || header.magic != cacheFileMagic) {
+    throw std::runtime_error("Not an OI cache file");
+  }
+  if (header.formatVersion != cacheFileFormatVersion) {
+    auto error = (boost::format("Unsupported cache file format version %1% "
+                                "(OID expected version %2%)") %
+                  header.formatVersion % cacheFileFormatVersion)
+                     .str();
+    throw std::runtime_error(error);
+  }
+}
+
+}  // namespace oi::detail
@@ -15,14 +15,17 @@
  */
 #pragma once
 
-#include <boost/archive/text_iarchive.hpp>
-#include <boost/archive/text_oarchive.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
 #include <boost/serialization/map.hpp>
 #include <boost/serialization/set.hpp>
 #include <boost/serialization/shared_ptr.hpp>
 #include <boost/serialization/string.hpp>
 #include <boost/serialization/unordered_map.hpp>
 #include <boost/serialization/vector.hpp>
+#include <cstdint>
+#include <istream>
+#include <ostream>
 
 #include "oi/PaddingHunter.h"
 #include "oi/SymbolService.h"
@@ -75,3 +78,33 @@ DECL_SERIALIZE(TypeHierarchy);
 #undef DECL_SERIALIZE
 
 }  // namespace boost::serialization
+
+namespace oi::detail {
+
+/*
+ * Cache files are a small fixed header followed by a boost binary archive of
+ * the target's build ID and of the cached data. The header lets us reject
+ * files written in another format (e.g. the former text archives) before
+ * handing them to boost. Bump `cacheFileFormatVersion` whenever the archive
+ * layout changes in a way DEFINE_TYPE_VERSION can't detect.
+ */
+using CacheIArchive = boost::archive::binary_iarchive;
+using CacheOArchive = boost::archive::binary_oarchive;
+
+constexpr uint64_t cacheFileMagic = 0x4548434143494f00;  // "\0OICACHE"
+constexpr uint64_t cacheFileFormatVersion = 1;
+
+struct CacheFileHeader {
+  uint64_t magic;
+  uint64_t formatVersion;
+};
+
+void writeCacheFileHeader(std::ostream&);
+
+/*
+ * Consume the header from the stream. Throws if it's missing, or if the file
+ * was written in another format version.
+ */
+void readCacheFileHeader(std::istream&);
+
+}  // namespace oi::detail
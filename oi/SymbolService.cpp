@@ -115,6 +115,48 @@ SymbolService::SymbolService(fs::path executablePath)
   }
 }
 
+bool SymbolService::retarget(pid_t pid) {
+  if (!std::holds_alternative<pid_t>(target)) {
+    LOG(ERROR) << "Only a process' SymbolService can be retargeted";
+    return false;
+  }
+  if (std::get<pid_t>(target) == pid) {
+    return true;
+  }
+
+  auto buildID = locateBuildID();
+
+  std::vector<std::pair<uint64_t, uint64_t>> exeAddrs;
+  LoadExecutableAddressRange(pid, exeAddrs);
+
+  /*
+   * Re-reporting the modules keeps the ones that are mapped at the same
+   * address in the new process, so unchanged ELF files aren't re-opened.
+   */
+  dwfl_report_begin(dwfl);
+  bool ok = loadModulesFromPid(pid);
+  if (dwfl_report_end(dwfl, nullptr, nullptr) != 0) {
+    LOG(ERROR) << "dwfl_report_end: " << dwfl_errmsg(-1);
+    ok = false;
+  }
+  if (!ok) {
+    return false;
+  }
+
+  target = pid;
+  executableAddrs = std::move(exeAddrs);
+  funcDescs.clear();
+  globalDescs.clear();
+  symbolIndex.reset();
+  demangledSymbolIndex.reset();
+
+  if (locateBuildID() != buildID) {
+    LOG(ERROR) << "Process " << pid << " doesn't run the same binary";
+    return false;
+  }
+  return true;
+}
+
 SymbolService::~SymbolService() {
   if (dwfl != nullptr) {
     dwfl_end(dwfl);
@@ -125,31 +167,25 @@ SymbolService::~SymbolService() {
   }
 }
 
-struct ModParams {
-  std::string_view symName;
-  GElf_Sym sym;
-  GElf_Addr value;
-  std::vector<std::pair<uint64_t, uint64_t>>& exeAddrs;
+struct IndexParams {
+  std::unordered_map<std::string, SymbolInfo>& index;
+  const std::vector<std::pair<uint64_t, uint64_t>>& exeAddrs;
   bool demangle;
 };
 
 /**
- * Callback for dwfl_getmodules(). For the provided module we iterate
- * through its symbol table and look for the given symbol. Values
- * are passed in and out via the 'arg' parameter.
- *
- * @param[in] arg[0] - The symbol to locate.
- * @param[out] arg[1] - Symbol information if found.
- * @param[out] arg[2] - Address of the symbol if found.
+ * Callback for dwfl_getmodules(). Adds the symbols defined by the provided
+ * module to the index passed in via the 'arg' parameter.
  *
+ * Modules are visited in the same order as a lookup would and existing entries
+ * are never replaced, so the index holds the first definition of each symbol.
  */
-
-static int moduleCallback(Dwfl_Module* mod,
-                          void** /* userData */,
-                          const char* name,
-                          Dwarf_Addr /* start */,
-                          void* arg) {
-  ModParams* m = (ModParams*)arg;
+static int indexModuleCallback(Dwfl_Module* mod,
+                               void** /* userData */,
+                               const char* name,
+                               Dwarf_Addr /* start */,
+                               void* arg) {
+  auto* params = static_cast<IndexParams*>(arg);
 
   int nsym = dwfl_module_getsymtab(mod);
   VLOG(1) << "mod name: " << name << " "
@@ -165,42 +201,33 @@ static int moduleCallback(Dwfl_Module* mod,
     if (strncmp(name + nameLen - debugSuffixLen, debugSuffix, debugSuffixLen) ==
         0) {
       VLOG(1) << "Skipping debuginfo module";
-      m->value = 0;
       return DWARF_CB_OK;
     }
   }
 
   /* I think the first entry is always UNDEF */
   for (int i = 1; i < nsym; ++i) {
+    GElf_Sym sym{};
+    GElf_Addr value = 0;
     Elf* elf = nullptr;
     GElf_Word shndxp = 0;
 
-    const char* lookupResult = dwfl_module_getsym_info(
-        mod, i, &m->sym, &m->value, &shndxp, &elf, nullptr);
-    if (lookupResult == nullptr || lookupResult[0] == '\0') {
+    const char* lookupResult =
+        dwfl_module_getsym_info(mod, i, &sym, &value, &shndxp, &elf, nullptr);
+    if (lookupResult == nullptr || lookupResult[0] == '\0' ||
+        shndxp == SHN_UNDEF || value == 0) {
       continue;
     }
 
-    std::string symName = lookupResult;
-
-    if (m->demangle) {
-      symName = boost::core::demangle(symName.c_str());
-    }
-
     switch
-      GELF_ST_TYPE(m->sym.st_info) {
+      GELF_ST_TYPE(sym.st_info) {
         case STT_SECTION:
         case STT_FILE:
         case STT_TLS:
         case STT_NOTYPE:
-          break;
+          continue;
 
         case STT_OBJECT:
-          if (shndxp != SHN_UNDEF && symName == m->symName) {
-            VLOG(1) << "Symbol lookup successful for " << symName
-                    << " in module " << name;
-            return DWARF_CB_ABORT;
-          }
           break;
 
         default:
@@ -209,19 +236,19 @@ static int moduleCallback(Dwfl_Module* mod,
            * to us here has NOTYPE yet readelf shows me it is defined
            * as an STT_FUNC. Confused...
            */
-          if (shndxp != SHN_UNDEF && symName == m->symName &&
-              isExecutableAddr(m->value, m->exeAddrs)) {
-            VLOG(1) << "Symbol lookup successful for " << symName
-                    << " in module " << name;
-
-            return DWARF_CB_ABORT;
+          if (!isExecutableAddr(value, params->exeAddrs)) {
+            continue;
           }
           break;
       }
+
+    std::string symName = params->demangle
+                              ? boost::core::demangle(lookupResult)
+                              : std::string{lookupResult};
+    params->index.try_emplace(std::move(symName),
+                              SymbolInfo{value, sym.st_size});
   }
 
-  // Set m->value to 0 if symbol is not found
-  m->value = 0;
   return DWARF_CB_OK;
 }
 
@@ -347,20 +374,29 @@ std::optional<drgn_qualified_type> SymbolService::findTypeOfAddr(
  * @param[in] symName - symbol to resolve
  * @return - A std::optional with the symbol's information
  */
-std::optional<SymbolInfo> SymbolService::locateSymbol(
-    const std::string& symName, bool demangle) {
-  ModParams m = {.symName = symName,
-                 .sym = {},
-                 .value = 0,
-                 .exeAddrs = executableAddrs,
-                 .demangle = demangle};
+const SymbolService::SymbolIndex& SymbolService::getSymbolIndex(
+    bool demangle) {
+  auto& index = demangle ? demangledSymbolIndex : symbolIndex;
+  if (!index.has_value()) {
+    LOG(INFO) << "Indexing " << (demangle ? "demangled " : "")
+              << "symbols. This might take a while";
 
-  dwfl_getmodules(dwfl, moduleCallback, (void*)&m, 0);
+    index.emplace();
+    IndexParams params{*index, executableAddrs, demangle};
+    dwfl_getmodules(dwfl, indexModuleCallback, (void*)&params, 0);
 
-  if (m.value == 0) {
-    return std::nullopt;
+    VLOG(1) << "Indexed " << index->size() << " symbols";
+  }
+  return *index;
+}
+
+std::optional<SymbolInfo> SymbolService::locateSymbol(
+    const std::string& symName, bool demangle) {
+  const auto& index = getSymbolIndex(demangle);
+  if (auto it = index.find(symName); it != end(index)) {
+    return it->second;
   }
-  return SymbolInfo{m.value, m.sym.st_size};
+  return std::nullopt;
 }
 
 static std::string bytesToHexString(const unsigned char* bytes, int nbbytes) {
@@ -377,25 +413,16 @@ static std::string bytesToHexString(const unsigned char* bytes, int nbbytes) {
 }
 
 /**
- * Callback for dwfl_getmodules(). For the provided module we lookup
- * its build ID and pass it back via the 'arg' parameter.
- * We expect the target program to always be the first module passed
- * to this callback. So we always return DWARF_CB_ABORT, as this is
- * the only build ID we are interested in.
+ * Lookup the build ID of the provided module.
  */
-static int buildIDCallback(Dwfl_Module* mod,
-                           void** /* userData */,
-                           const char* name,
-                           Dwarf_Addr /* start */,
-                           void* arg) {
-  auto* buildID = static_cast<std::optional<std::string>*>(arg);
-
+static std::optional<std::string> moduleBuildID(Dwfl_Module* mod,
+                                                const char* name) {
   // We must call dwfl_module_getelf before using dwfl_module_build_id
   GElf_Addr bias = 0;
   Elf* elf = dwfl_module_getelf(mod, &bias);
   if (elf == nullptr) {
     LOG(ERROR) << "Failed to getelf for " << name << ": " << dwfl_errmsg(-1);
-    return DWARF_CB_ABORT;
+    return std::nullopt;
   }
 
   GElf_Addr vaddr = 0;
@@ -403,14 +430,29 @@ static int buildIDCallback(Dwfl_Module* mod,
 
   int nbbytes = dwfl_module_build_id(mod, &bytes, &vaddr);
   if (nbbytes <= 0) {
-    *buildID = std::nullopt;
     LOG(ERROR) << "Build ID not found for " << name;
-  } else {
-    *buildID = bytesToHexString(bytes, nbbytes);
-    VLOG(1) << "Build ID lookup successful for " << name << ": "
-            << buildID->value();
+    return std::nullopt;
   }
 
+  auto buildID = bytesToHexString(bytes, nbbytes);
+  VLOG(1) << "Build ID lookup successful for " << name << ": " << buildID;
+  return buildID;
+}
+
+/**
+ * Callback for dwfl_getmodules(). For the provided module we lookup
+ * its build ID and pass it back via the 'arg' parameter.
+ * We expect the target program to always be the first module passed
+ * to this callback. So we always return DWARF_CB_ABORT, as this is
+ * the only build ID we are interested in.
+ */
+static int buildIDCallback(Dwfl_Module* mod,
+                           void** /* userData */,
+                           const char* name,
+                           Dwarf_Addr /* start */,
+                           void* arg) {
+  auto* buildID = static_cast<std::optional<std::string>*>(arg);
+  *buildID = moduleBuildID(mod, name);
   return DWARF_CB_ABORT;
 }
 
@@ -421,6 +463,19 @@ std::optional<std::string> SymbolService::locateBuildID() {
   return buildID;
 }
 
+std::optional<std::string> SymbolService::locateBuildID(uintptr_t addr) {
+  Dwfl_Module* mod = dwfl_addrmodule(dwfl, addr);
+  if (mod == nullptr) {
+    LOG(ERROR) << "No module contains address " << std::hex << addr
+               << std::dec << ": " << dwfl_errmsg(-1);
+    return std::nullopt;
+  }
+
+  const char* name = dwfl_module_info(mod, nullptr, nullptr, nullptr, nullptr,
+                                      nullptr, nullptr, nullptr);
+  return moduleBuildID(mod, name);
+}
+
 struct drgn_program* SymbolService::getDrgnProgram() {
   if (hardDisableDrgn) {
     LOG(ERROR) << "drgn is disabled, refusing to initialize";
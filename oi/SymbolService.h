@@ -19,6 +19,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <variant>
 #include <vector>
@@ -28,6 +29,7 @@
 
 struct Dwfl;
 struct drgn_program;
+struct drgn_type;
 struct irequest;
 
 namespace oi::detail {
@@ -47,7 +49,22 @@ class SymbolService {
 
   struct drgn_program* getDrgnProgram();
 
+  /*
+   * Point a live-process SymbolService at another process running the same
+   * binary. Module addresses are reloaded and the address-bearing descriptor
+   * caches are dropped, but drgn's type information is kept as it doesn't
+   * depend on the process. Returns false if the new process runs a different
+   * binary, in which case the service must not be used anymore.
+   */
+  bool retarget(pid_t);
+
   std::optional<std::string> locateBuildID();
+
+  /*
+   * The build ID of the ELF object mapped at @param addr, which may be a
+   * shared library rather than the main executable.
+   */
+  std::optional<std::string> locateBuildID(uintptr_t addr);
   std::optional<SymbolInfo> locateSymbol(const std::string&,
                                          bool demangle = false);
 
@@ -64,6 +81,17 @@ class SymbolService {
   std::unordered_map<std::string, std::shared_ptr<FuncDesc>> funcDescs;
   std::unordered_map<std::string, std::shared_ptr<GlobalDesc>> globalDescs;
 
+  /*
+   * Mapping of parent classes to child classes, built by
+   * type_graph::AddChildren from a scan of every type in the program. Keys
+   * are unqualified names viewing drgn's own strings, so both keys and values
+   * are valid for as long as the drgn program is, and the scan is only done
+   * once per program rather than once per probe.
+   */
+  using ChildClasses =
+      std::unordered_map<std::string_view, std::vector<drgn_type*>>;
+  std::optional<ChildClasses> childClasses;
+
   void setHardDisableDrgn(bool val) {
     hardDisableDrgn = val;
   }
@@ -80,6 +108,17 @@ class SymbolService {
   std::vector<std::pair<uint64_t, uint64_t>> executableAddrs{};
   bool hardDisableDrgn = false;
 
+  /*
+   * Symbols defined by all the modules, indexed by name. Each index is built
+   * on its first lookup: scanning the symbol tables (and demangling them) is
+   * expensive on large binaries.
+   */
+  using SymbolIndex = std::unordered_map<std::string, SymbolInfo>;
+  std::optional<SymbolIndex> symbolIndex;
+  std::optional<SymbolIndex> demangledSymbolIndex;
+
+  const SymbolIndex& getSymbolIndex(bool demangle);
+
  protected:
   SymbolService() = default;  // For unit tests
 };
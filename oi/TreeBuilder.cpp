@@ -17,22 +17,26 @@
 
 #include <glog/logging.h>
 
+#include <array>
 #include <boost/algorithm/string/regex.hpp>
 #include <boost/scope_exit.hpp>
 #include <fstream>
 #include <iostream>
 #include <limits>
 #include <msgpack.hpp>
+#include <span>
 #include <stdexcept>
 
 #include "oi/ContainerInfo.h"
 #include "oi/DrgnUtils.h"
 #include "oi/Metrics.h"
+#include "oi/NodeFile.h"
 #include "oi/OICodeGen.h"
 #include "oi/PaddingHunter.h"
 #include "rocksdb/db.h"
 #include "rocksdb/options.h"
 #include "rocksdb/statistics.h"
+#include "rocksdb/write_batch.h"
 
 extern "C" {
 #include <drgn.h>
@@ -55,7 +59,14 @@ enum class TrackPointerTag : uint64_t {
 TreeBuilder::TreeBuilder(Config c) : config{std::move(c)} {
   buffer = std::make_unique<msgpack::sbuffer>();
 
-  auto testdbPath = "/tmp/testdb_" + std::to_string(getpid());
+  if (config.nodeFilePath.has_value()) {
+    nodeFile = std::make_unique<nodefile::NodeFileWriter>(*config.nodeFilePath,
+                                                          FIRST_NODE_ID);
+    return;
+  }
+
+  auto testdbPath =
+      config.dbPath.value_or("/tmp/testdb_" + std::to_string(getpid()));
   if (auto status = rocksdb::DestroyDB(testdbPath, {}); !status.ok()) {
     LOG(FATAL) << "RocksDB error while destroying database: "
                << status.ToString();
@@ -73,12 +84,25 @@ TreeBuilder::TreeBuilder(Config c) : config{std::move(c)} {
   if (auto status = rocksdb::DB::Open(options, testdbPath, &db); !status.ok()) {
     LOG(FATAL) << "RocksDB error while opening database: " << status.ToString();
   }
+  batch = std::make_unique<rocksdb::WriteBatch>();
+}
+
+/*
+ * RocksDB keys are the node IDs as fixed-width, big-endian integers, so that
+ * the default bytewise comparator sorts them in ID order.
+ */
+static std::array<char, sizeof(uint64_t)> nodeKey(uint64_t id) {
+  std::array<char, sizeof(uint64_t)> key{};
+  for (size_t i = 0; i < key.size(); i++) {
+    key[i] = static_cast<char>(id >> (8 * (key.size() - 1 - i)));
+  }
+  return key;
 }
 
 struct TreeBuilder::Variable {
   struct drgn_type* type;
   std::string_view name;
-  std::string typePath;
+  std::string_view typePath;
   std::optional<bool> isset = std::nullopt;
   bool isStubbed = false;
 };
@@ -135,8 +159,8 @@ struct TreeBuilder::Node {
    * The type of this node, as it would be written in the code
    * (e.g. `std::vector<int>`, `float`, `MyStruct`).
    */
-  std::string typeName{};
-  std::string typePath{};
+  std::string_view typeName{};
+  std::string_view typePath{};
   bool isTypedef{};
   /**
    * The compile-time-determinable size (i.e. memory footprint measured in
@@ -176,6 +200,13 @@ struct TreeBuilder::Node {
    */
   size_t exclusiveSize{};
 
+  /**
+   * Set on the summary nodes which stand in for the elements of a container
+   * when aggregating elements: the number of elements summarised. Their
+   * `staticSize` and `exclusiveSize` are the total over all these elements.
+   */
+  std::optional<size_t> aggregateCount{std::nullopt};
+
   MSGPACK_DEFINE_ARRAY(id,
                        name,
                        typeName,
@@ -188,26 +219,74 @@ struct TreeBuilder::Node {
                        pointer,
                        children,
                        isset,
-                       exclusiveSize)
+                       exclusiveSize,
+                       aggregateCount)
+};
+
+/*
+ * A node whose children are still to be processed. `process` keeps these on
+ * an explicit stack rather than recursing, so deep object graphs (e.g. long
+ * linked lists with ChaseRawPointers) can't overflow the native stack.
+ */
+struct TreeBuilder::Frame {
+  /* Where the children come from, and how their sizes roll up */
+  enum class Kind {
+    Leaf,
+    Pointer,
+    Typedef,
+    Members,
+    ContainerAdapter,
+    Variant,
+    Elements,
+  };
+
+  Node node;
+  const TypeDesc* desc;
+  bool isStubbed;
+  Kind kind = Kind::Leaf;
+  size_t numChildren = 0;
+  /* Number of children which have been started so far */
+  size_t childIndex = 0;
+  uint64_t memberSizes = 0;
+  /* Types of the children of containers, repeated for each element */
+  std::span<const struct drgn_qualified_type> elementTypes{};
+
+  void setChildren(Kind kind_, size_t count, NodeID& nextNodeID) {
+    kind = kind_;
+    numChildren = count;
+    node.children = {nextNodeID, nextNodeID + count};
+    nextNodeID += count;
+  }
 };
 
 TreeBuilder::~TreeBuilder() {
   /* FB: Remove error IDs, Strobelight doesn't handle them yet */
   std::erase(rootIDs, ERROR_NODE_ID);
 
+  if (nodeFile) {
+    try {
+      nodeFile->finish(VERSION, rootIDs);
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "Error while finishing node file: " << e.what();
+    }
+    return;
+  }
+
   /*
    * Now that all the Nodes have been inserted in the DB,
    * we can insert the DBHeader with the proper list of rootIDs.
    */
   const DBHeader header{.version = VERSION, .rootIDs = std::move(rootIDs)};
-  auto serializedHeader = serialize(header);
-
-  rocksdb::WriteOptions options{};
-  options.disableWAL = true;
-  if (auto status =
-          db->Put(options, std::to_string(ROOT_NODE_ID), serializedHeader);
-      !status.ok()) {
-    LOG(ERROR) << "RocksDB error while writing DBHeader: " << status.ToString();
+  try {
+    auto key = nodeKey(ROOT_NODE_ID);
+    if (auto status = batch->Put(rocksdb::Slice{key.data(), key.size()},
+                                 serialize(header));
+        !status.ok()) {
+      throw std::runtime_error(status.ToString());
+    }
+    writeBatch();
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "Error while writing DBHeader: " << e.what();
   }
 
   if (auto status = db->Close(); !status.ok()) {
@@ -226,51 +305,62 @@ void TreeBuilder::build(const std::vector<uint64_t>& data,
                         const std::string& argName,
                         struct drgn_type* type,
                         const TypeHierarchy& typeHierarchy) {
+  // HACK: OID's first 4 outputs are dummy 0s
+  std::span<const uint64_t> values{data};
+  values = values.subspan(std::min<size_t>(4, values.size()));
+
+  build(DataSegmentCursor{values}, argName, type, typeHierarchy);
+}
+
+void TreeBuilder::build(DataSegmentCursor data,
+                        const std::string& argName,
+                        struct drgn_type* type,
+                        const TypeHierarchy& typeHierarchy) {
   th = &typeHierarchy;
   oidData = &data;
 
-  oidDataIndex = 4;  // HACK: OID's first 4 outputs are dummy 0s
+  // `data` is about to go out of scope, don't keep pointing to it
+  BOOST_SCOPE_EXIT_ALL(this) {
+    th = nullptr;
+    oidData = nullptr;
+    typeDescs.clear();
+  };
 
   metrics::Tracing _("build_tree");
   VLOG(1) << "Building tree...";
 
-  {
-    auto& rootID = rootIDs.emplace_back(nextNodeID++);
-
-    try {
-      process(rootID, {.type = type, .name = argName, .typePath = argName});
-    } catch (...) {
-      // Mark the failure using the error node ID
-      rootID = ERROR_NODE_ID;
-      throw;
-    }
+  auto& rootID = rootIDs.emplace_back(nextNodeID++);
+  try {
+    process(rootID, {.type = type, .name = argName, .typePath = argName});
+  } catch (...) {
+    // Mark the failure using the error node ID
+    rootID = ERROR_NODE_ID;
+    throw;
   }
 
   VLOG(1) << "Finished building tree";
-  rocksdb::CompactRangeOptions opts;
-  rocksdb::Status s = db->CompactRange(opts, nullptr, nullptr);
-  if (!s.ok()) {
-    LOG(FATAL) << "RocksDB error while compacting: " << s.ToString();
+  if (db != nullptr) {
+    writeBatch();
   }
-  VLOG(1) << "Finished compacting db";
 
-  // Were all object sizes consumed?
-  if (oidDataIndex != oidData->size()) {
+  // Were all object sizes consumed? Reading on may throw on malformed data.
+  size_t consumed = data.consumed();
+  if (data.next().has_value()) {
+    size_t reported = consumed + 1;
+    while (data.next().has_value()) {
+      reported++;
+    }
+
     if (config.strict) {
       LOG(FATAL) << "some object sizes not consumed and OID is in strict mode!"
-                 << "reported: " << oidData->size() << " consumed "
-                 << oidDataIndex;
+                 << "reported: " << reported << " consumed " << consumed;
     }
     LOG(WARNING) << "WARNING: some object sizes not consumed;"
                  << "object tree may be inaccurate. "
-                 << "reported: " << oidData->size() << " consumed "
-                 << oidDataIndex;
+                 << "reported: " << reported << " consumed " << consumed;
   } else {
-    VLOG(1) << "Consumed all object sizes: " << oidDataIndex;
+    VLOG(1) << "Consumed all object sizes: " << consumed;
   }
-
-  th = nullptr;
-  oidData = nullptr;
 }
 
 void TreeBuilder::dumpJson() {
@@ -369,18 +459,127 @@ uint64_t TreeBuilder::getDrgnTypeSize(struct drgn_type* type) {
                            " " + err->message);
 }
 
+const TreeBuilder::TypeDesc& TreeBuilder::getTypeDesc(struct drgn_type* type) {
+  if (auto it = typeDescs.find(type); it != typeDescs.end()) {
+    return it->second;
+  }
+
+  TypeDesc desc{
+      .name = drgnTypeToName(type),
+      .elementTypePath = "",
+      .staticSize = getDrgnTypeSize(type),
+      .kind = drgn_type_kind(type),
+      .isDummy = th->knownDummyTypeList.contains(type),
+      .isPrimitive = isPrimitive(type),
+      .isStandardInteger = false,
+      .isContainer = isContainer(type),
+      .captureThriftIsset = th->thriftIssetStructTypes.contains(type),
+      .isStaticOnly = false,
+      .target = nullptr,
+      .members = nullptr,
+      .descendants = nullptr,
+      .container = nullptr,
+      .arrayElementType = {},
+      .padding = nullptr,
+  };
+  desc.elementTypePath = desc.name + "[]";
+
+  if (desc.kind == DRGN_TYPE_TYPEDEF) {
+    const static boost::regex standardIntegerRegex{
+        "((s?size)|(u?int(_fast|_least)?(8|16|32|64|128|ptr))|(ptrdiff))_"
+        "t"};
+    desc.isStandardInteger =
+        boost::regex_match(desc.name, standardIntegerRegex);
+
+    if (auto it = th->typedefMap.find(type); it != th->typedefMap.end()) {
+      desc.target = it->second;
+    }
+  } else if (desc.kind == DRGN_TYPE_POINTER) {
+    if (auto it = th->pointerToTypeMap.find(type);
+        it != th->pointerToTypeMap.end()) {
+      desc.target = it->second;
+    }
+  }
+
+  if (auto it = th->classMembersMap.find(type);
+      it != th->classMembersMap.end()) {
+    desc.members = &it->second;
+  }
+  if (auto it = th->descendantClasses.find(type);
+      it != th->descendantClasses.end()) {
+    desc.descendants = &it->second;
+  }
+  if (auto it = th->containerTypeMap.find(type);
+      it != th->containerTypeMap.end()) {
+    desc.container = &it->second;
+  }
+  if (desc.kind == DRGN_TYPE_ARRAY && desc.isContainer) {
+    struct drgn_type* elementType = nullptr;
+    size_t numElems = 0;
+    if (config.features[Feature::TypeGraph]) {
+      elementType = drgn_type_type(type).type;
+      numElems = drgn_type_length(type);
+    } else {
+      drgn_utils::getDrgnArrayElementType(type, &elementType, numElems);
+    }
+    assert(numElems > 0);
+    desc.arrayElementType =
+        drgn_qualified_type{elementType, (enum drgn_qualifiers)(0)};
+  }
+  if (config.features[Feature::GenPaddingStats] && paddedStructs != nullptr) {
+    if (auto it = paddedStructs->find(desc.name); it != paddedStructs->end()) {
+      desc.padding = &it->second;
+    }
+  }
+  if (config.aggregateElements) {
+    desc.isStaticOnly = isStaticOnly(desc);
+  }
+
+  return typeDescs.emplace(type, std::move(desc)).first->second;
+}
+
+bool TreeBuilder::isStaticOnly(const TypeDesc& desc) {
+  // Mirrors what `process` reads for each kind of type. Types can only refer
+  // to themselves through pointers, which are never followed here.
+  switch (desc.kind) {
+    case DRGN_TYPE_POINTER:
+      return desc.isDummy || desc.target == nullptr ||
+             !config.features[Feature::ChaseRawPointers];
+    case DRGN_TYPE_TYPEDEF:
+      return desc.isStandardInteger || desc.target == nullptr ||
+             getTypeDesc(desc.target).isStaticOnly;
+    case DRGN_TYPE_CLASS:
+    case DRGN_TYPE_STRUCT:
+    case DRGN_TYPE_ARRAY:
+      if (desc.isDummy) {
+        return true;
+      }
+      if (desc.isContainer || desc.descendants != nullptr ||
+          desc.captureThriftIsset) {
+        return false;
+      }
+      return desc.members == nullptr ||
+             std::ranges::all_of(*desc.members, [this](const auto& member) {
+               return member.isStubbed || getTypeDesc(member.type).isStaticOnly;
+             });
+    default:
+      return true;
+  }
+}
+
 uint64_t TreeBuilder::next() {
-  if (oidDataIndex >= oidData->size()) {
+  auto val = oidData->next();
+  if (!val.has_value()) {
     throw std::runtime_error("Unexpected end of data");
   }
-  VLOG(3) << "next = " << (void*)(*oidData)[oidDataIndex];
-  return (*oidData)[oidDataIndex++];
+  VLOG(3) << "next = " << (void*)*val;
+  return *val;
 }
 
-bool TreeBuilder::isContainer(const Variable& variable) {
-  return th->containerTypeMap.contains(variable.type) ||
-         (drgn_type_kind(variable.type) == DRGN_TYPE_ARRAY &&
-          drgn_type_length(variable.type) > 0);
+bool TreeBuilder::isContainer(struct drgn_type* type) {
+  return th->containerTypeMap.contains(type) ||
+         (drgn_type_kind(type) == DRGN_TYPE_ARRAY &&
+          drgn_type_length(type) > 0);
 }
 
 bool TreeBuilder::isPrimitive(struct drgn_type* type) {
@@ -415,192 +614,338 @@ void TreeBuilder::setSize(TreeBuilder::Node& node,
 }
 
 TreeBuilder::Node TreeBuilder::process(NodeID id, Variable variable) {
-  Node node{
-      .id = id,
-      .name = variable.name,
-      .typeName = drgnTypeToName(variable.type),
-      .typePath = std::move(variable.typePath),
-      .staticSize = getDrgnTypeSize(variable.type),
-      .isset = variable.isset,
+  // Depth-first, as if `process` recursed into each child in turn. Only the
+  // nodes on the current path are kept, one frame per level.
+  std::vector<Frame> frames;
+  frames.push_back(startNode(id, variable));
+
+  while (true) {
+    auto& frame = frames.back();
+    if (frame.childIndex < frame.numChildren) {
+      auto [childID, child] = nextChild(frame);
+      frames.push_back(startNode(childID, child));
+      continue;
+    }
+
+    auto node = finishNode(frame);
+    frames.pop_back();
+    if (frames.empty()) {
+      return node;
+    }
+    addChild(frames.back(), node);
+  }
+}
+
+/*
+ * Create the node for the given variable and read everything which comes
+ * before its children in the data segment. Its children are allocated their
+ * IDs here but are only processed later, one at a time (see `nextChild`).
+ */
+TreeBuilder::Frame TreeBuilder::startNode(NodeID id,
+                                          const Variable& variable) {
+  const TypeDesc* desc = &getTypeDesc(variable.type);
+  Frame frame{
+      .node =
+          Node{
+              .id = id,
+              .name = variable.name,
+              .typeName = desc->name,
+              .typePath = variable.typePath,
+              .staticSize = desc->staticSize,
+              .isset = variable.isset,
+          },
+      .desc = desc,
+      .isStubbed = variable.isStubbed,
   };
+  auto& node = frame.node;
   VLOG(2) << "Processing node [" << id << "] (name: '" << variable.name
           << "', typeName: '" << node.typeName
           << "', kind: " << drgnKindStr(variable.type) << ")"
           << (variable.isStubbed ? " STUBBED" : "")
-          << (th->knownDummyTypeList.contains(variable.type) ? " DUMMY" : "");
+          << (desc->isDummy ? " DUMMY" : "");
   // Default dynamic size to 0 and calculate fallback exclusive size
   setSize(node, 0, 0);
-  if (!variable.isStubbed) {
-    switch (drgn_type_kind(variable.type)) {
-      case DRGN_TYPE_POINTER:
-        if (config.features[Feature::ChaseRawPointers]) {
-          // Pointers to incomplete types are stubbed out
-          // See OICodeGen::enumeratePointerType
-          if (th->knownDummyTypeList.contains(variable.type)) {
-            break;
-          }
+  if (variable.isStubbed) {
+    return frame;
+  }
 
-          auto entry = th->pointerToTypeMap.find(variable.type);
-          if (entry != th->pointerToTypeMap.end()) {
-            auto innerTypeKind = drgn_type_kind(entry->second);
-            if (innerTypeKind != DRGN_TYPE_FUNCTION) {
-              node.pointer = next();
-              if (innerTypeKind == DRGN_TYPE_VOID) {
-                break;
-              }
-              if (next() == (uint64_t)TrackPointerTag::skipped) {
-                break;
-              }
+  switch (desc->kind) {
+    case DRGN_TYPE_POINTER:
+      if (config.features[Feature::ChaseRawPointers]) {
+        // Pointers to incomplete types are stubbed out
+        // See OICodeGen::enumeratePointerType
+        if (desc->isDummy) {
+          break;
+        }
+
+        if (desc->target != nullptr) {
+          auto innerTypeKind = drgn_type_kind(desc->target);
+          if (innerTypeKind != DRGN_TYPE_FUNCTION) {
+            node.pointer = next();
+            if (innerTypeKind == DRGN_TYPE_VOID) {
+              break;
+            }
+            if (next() == (uint64_t)TrackPointerTag::skipped) {
+              break;
             }
-            auto childID = nextNodeID++;
-            auto child = process(childID, Variable{entry->second, "", ""});
-            node.children = {childID, childID + 1};
-            setSize(node, child.staticSize + child.dynamicSize,
-                    child.staticSize + child.dynamicSize);
           }
+          frame.setChildren(Frame::Kind::Pointer, 1, nextNodeID);
         }
+      }
+      break;
+    case DRGN_TYPE_TYPEDEF:
+      // We don't expand typedefs for well-known integer types from `stdint.h`
+      // to prevent our output from being extremely verbose. We treat them as
+      // if they are primitives directly (hence this check coming *before* we
+      // set `node.isTypedef`).
+      if (desc->isStandardInteger) {
         break;
-      case DRGN_TYPE_TYPEDEF: {
-        const static boost::regex standardIntegerRegex{
-            "((s?size)|(u?int(_fast|_least)?(8|16|32|64|128|ptr))|(ptrdiff))_"
-            "t"};
-        // We don't expand typedefs for well-known integer types from `stdint.h`
-        // to prevent our output from being extremely verbose. We treat them as
-        // if they are primitives directly (hence this check coming *before* we
-        // set `node.isTypedef`).
-        if (boost::regex_match(node.typeName, standardIntegerRegex)) {
-          break;
-        }
-        node.isTypedef = true;
-        auto entry = th->typedefMap.find(variable.type);
-        if (entry != th->typedefMap.end()) {
-          auto childID = nextNodeID++;
-          auto child = process(childID, Variable{entry->second, "", ""});
-          node.children = {childID, childID + 1};
-          setSize(node, child.dynamicSize,
-                  child.dynamicSize + child.staticSize);
+      }
+      node.isTypedef = true;
+      if (desc->target != nullptr) {
+        frame.setChildren(Frame::Kind::Typedef, 1, nextNodeID);
+      }
+      break;
+    case DRGN_TYPE_CLASS:
+    case DRGN_TYPE_STRUCT:
+    case DRGN_TYPE_ARRAY:
+      if (desc->isDummy) {
+        break;
+      } else if (desc->isContainer) {
+        processContainer(variable, frame);
+      } else {
+        if (desc->descendants != nullptr) {
+          // The first item of data in dynamic classes identifies which
+          // concrete type we should process it as, represented as an index
+          // into the vector of child classes, or -1 to processes this type
+          // as itself.
+          const auto& descendants = *desc->descendants;
+          auto val = next();
+          if (val != (uint64_t)-1) {
+            desc = &getTypeDesc(descendants[val]);
+            frame.desc = desc;
+            node.typeName = desc->name;
+            node.staticSize = desc->staticSize;
+          }
         }
-      } break;
-      case DRGN_TYPE_CLASS:
-      case DRGN_TYPE_STRUCT:
-      case DRGN_TYPE_ARRAY:
-        if (th->knownDummyTypeList.contains(variable.type)) {
+
+        if (desc->members == nullptr || desc->members->empty()) {
           break;
-        } else if (isContainer(variable)) {
-          processContainer(variable, node);
-        } else {
-          drgn_type* objectType = variable.type;
-          if (auto it = th->descendantClasses.find(objectType);
-              it != th->descendantClasses.end()) {
-            // The first item of data in dynamic classes identifies which
-            // concrete type we should process it as, represented as an index
-            // into the vector of child classes, or -1 to processes this type
-            // as itself.
-            const auto& descendants = it->second;
-            auto val = next();
-            if (val != (uint64_t)-1) {
-              objectType = descendants[val];
-              node.typeName = drgnTypeToName(objectType);
-              node.staticSize = getDrgnTypeSize(objectType);
-            }
-          }
+        }
 
-          auto entry = th->classMembersMap.find(objectType);
-          if (entry == th->classMembersMap.end() || entry->second.empty()) {
-            break;
-          }
+        frame.setChildren(Frame::Kind::Members, desc->members->size(),
+                          nextNodeID);
+      }
+      break;
+    default:
+      // The remaining types are all described entirely by their static size,
+      // and hence need no special handling.
+      break;
+  }
 
-          const auto& members = entry->second;
-          node.children = {nextNodeID, nextNodeID + members.size()};
-          nextNodeID += members.size();
-          auto childID = node.children->first;
-
-          bool captureThriftIsset =
-              th->thriftIssetStructTypes.contains(objectType);
-
-          uint64_t memberSizes = 0;
-          for (std::size_t i = 0; i < members.size(); i++) {
-            std::optional<bool> isset;
-            if (captureThriftIsset && i < members.size() - 1) {
-              // Retrieve isset value for each member variable, except Thrift's
-              // __isset field, which we assume comes last.
-              // A value of -1 indicates a non-optional field for which we
-              // don't record an isset value.
-              auto val = next();
-              if (val != (uint64_t)-1) {
-                isset = val;
-              }
-            }
-            const auto& member = members[i];
-            auto child =
-                process(childID++,
-                        Variable{member.type, member.member_name,
-                                 member.member_name, isset, member.isStubbed});
-            node.dynamicSize += child.dynamicSize;
-            memberSizes += child.dynamicSize + child.staticSize;
-          }
-          setSize(node, node.dynamicSize, memberSizes);
+  return frame;
+}
+
+/*
+ * Read whatever comes before the frame's next child in the data segment and
+ * return the child's ID and variable.
+ */
+std::pair<TreeBuilder::NodeID, TreeBuilder::Variable> TreeBuilder::nextChild(
+    Frame& frame) {
+  auto i = frame.childIndex++;
+  auto childID = frame.node.children->first + i;
+
+  switch (frame.kind) {
+    case Frame::Kind::Pointer:
+    case Frame::Kind::Typedef:
+      return {childID, Variable{frame.desc->target, "", ""}};
+    case Frame::Kind::Members: {
+      const auto& members = *frame.desc->members;
+      std::optional<bool> isset;
+      if (frame.desc->captureThriftIsset && i < members.size() - 1) {
+        // Retrieve isset value for each member variable, except Thrift's
+        // __isset field, which we assume comes last.
+        // A value of -1 indicates a non-optional field for which we
+        // don't record an isset value.
+        auto val = next();
+        if (val != (uint64_t)-1) {
+          isset = val;
         }
-        break;
-      default:
-        // The remaining types are all described entirely by their static size,
-        // and hence need no special handling.
-        break;
+      }
+      const auto& member = members[i];
+      return {childID, Variable{member.type, member.member_name,
+                                member.member_name, isset, member.isStubbed}};
     }
+    case Frame::Kind::ContainerAdapter:
+    case Frame::Kind::Variant:
+    case Frame::Kind::Elements: {
+      auto* type = frame.elementTypes[i % frame.elementTypes.size()].type;
+      return {childID, {.type = type,
+                        .name = "",
+                        .typePath = getTypeDesc(type).elementTypePath}};
+    }
+    case Frame::Kind::Leaf:
+      break;
+  }
+
+  throw std::runtime_error("Node [" + std::to_string(frame.node.id) +
+                           "] has no children to process");
+}
+
+/*
+ * Roll the sizes of a processed child up into the frame's node.
+ */
+void TreeBuilder::addChild(Frame& frame, const Node& child) {
+  auto& node = frame.node;
+  switch (frame.kind) {
+    case Frame::Kind::Pointer:
+      setSize(node, child.staticSize + child.dynamicSize,
+              child.staticSize + child.dynamicSize);
+      break;
+    case Frame::Kind::ContainerAdapter:
+      // Copy the underlying container's sizes and stats directly into this
+      // container adapter
+      node.containerStats = child.containerStats;
+      [[fallthrough]];
+    case Frame::Kind::Typedef:
+    case Frame::Kind::Variant:
+      setSize(node, child.dynamicSize, child.dynamicSize + child.staticSize);
+      break;
+    case Frame::Kind::Members:
+    case Frame::Kind::Elements:
+      node.dynamicSize += child.dynamicSize;
+      frame.memberSizes += child.dynamicSize + child.staticSize;
+      break;
+    case Frame::Kind::Leaf:
+      break;
+  }
+}
+
+/*
+ * Complete the frame's node once all of its children have been processed.
+ */
+TreeBuilder::Node TreeBuilder::finishNode(Frame& frame) {
+  auto& node = frame.node;
+  if (frame.kind == Frame::Kind::Members ||
+      frame.kind == Frame::Kind::Elements) {
+    setSize(node, node.dynamicSize, frame.memberSizes);
+  }
+
+  if (!frame.isStubbed && frame.desc->padding != nullptr) {
+    frame.desc->padding->instancesCnt++;
+    node.paddingSavingsSize = frame.desc->padding->savingSize;
+  }
 
-    if (config.features[Feature::GenPaddingStats]) {
-      auto entry = paddedStructs->find(node.typeName);
-      if (entry != paddedStructs->end()) {
-        entry->second.instancesCnt++;
-        node.paddingSavingsSize = entry->second.savingSize;
+  storeNode(node);
+  return node;
+}
+
+void TreeBuilder::storeNode(const Node& node) {
+  if (nodeFile) {
+    using nodefile::NodeRecord;
+
+    NodeRecord record{
+        .id = node.id,
+        .name = nodeFile->addString(node.name),
+        .typeName = nodeFile->addString(node.typeName),
+        .typePath = nodeFile->addString(node.typePath),
+        .staticSize = node.staticSize,
+        .dynamicSize = node.dynamicSize,
+        .exclusiveSize = node.exclusiveSize,
+        .paddingSavingsSize = node.paddingSavingsSize.value_or(0),
+        .pointer = node.pointer.value_or(0),
+        .length = 0,
+        .capacity = 0,
+        .elementStaticSize = 0,
+        .aggregateCount = node.aggregateCount.value_or(0),
+        .childrenStart = 0,
+        .childrenEnd = 0,
+        .flags = 0,
+        .reserved = 0,
+    };
+    if (node.isTypedef) {
+      record.flags |= NodeRecord::IsTypedef;
+    }
+    if (node.paddingSavingsSize.has_value()) {
+      record.flags |= NodeRecord::HasPaddingSavingsSize;
+    }
+    if (node.pointer.has_value()) {
+      record.flags |= NodeRecord::HasPointer;
+    }
+    if (node.containerStats.has_value()) {
+      record.flags |= NodeRecord::HasContainerStats;
+      record.length = node.containerStats->length;
+      record.capacity = node.containerStats->capacity;
+      record.elementStaticSize = node.containerStats->elementStaticSize;
+    }
+    if (node.children.has_value()) {
+      record.flags |= NodeRecord::HasChildren;
+      record.childrenStart = node.children->first;
+      record.childrenEnd = node.children->second;
+    }
+    if (node.aggregateCount.has_value()) {
+      record.flags |= NodeRecord::HasAggregateCount;
+    }
+    if (node.isset.has_value()) {
+      record.flags |= NodeRecord::HasIsset;
+      if (*node.isset) {
+        record.flags |= NodeRecord::Isset;
       }
     }
+
+    nodeFile->write(record);
+    return;
   }
 
-  rocksdb::WriteOptions options{};
-  options.disableWAL = true;
-  auto status = db->Put(options, std::to_string(node.id), serialize(node));
+  auto key = nodeKey(node.id);
+  auto status =
+      batch->Put(rocksdb::Slice{key.data(), key.size()}, serialize(node));
   if (!status.ok()) {
     throw std::runtime_error("RocksDB error while inserting node [" +
                              std::to_string(node.id) +
                              "]: " + status.ToString());
   }
-  return node;
+
+  // Large enough to amortise the cost of a write, small enough not to hold
+  // on to a significant part of the tree in memory
+  constexpr size_t WRITE_BATCH_SIZE = 4 << 20;
+  if (batch->GetDataSize() >= WRITE_BATCH_SIZE) {
+    writeBatch();
+  }
+}
+
+void TreeBuilder::writeBatch() {
+  rocksdb::WriteOptions options{};
+  options.disableWAL = true;
+  if (auto status = db->Write(options, batch.get()); !status.ok()) {
+    throw std::runtime_error("RocksDB error while writing nodes: " +
+                             status.ToString());
+  }
+  batch->Clear();
 }
 
-void TreeBuilder::processContainer(const Variable& variable, Node& node) {
+void TreeBuilder::processContainer(const Variable& variable, Frame& frame) {
+  auto& node = frame.node;
   VLOG(1) << "Processing container [" << node.id << "] of type '"
           << node.typeName << "'";
   ContainerTypeEnum kind = UNKNOWN_TYPE;
-  std::vector<struct drgn_qualified_type> elementTypes;
+  std::span<const struct drgn_qualified_type> elementTypes;
 
-  if (drgn_type_kind(variable.type) == DRGN_TYPE_ARRAY) {
+  const auto& desc = getTypeDesc(variable.type);
+  if (desc.kind == DRGN_TYPE_ARRAY) {
     kind = ARRAY_TYPE;
-    struct drgn_type* arrayElementType = nullptr;
-    size_t numElems = 0;
-    if (config.features[Feature::TypeGraph]) {
-      arrayElementType = drgn_type_type(variable.type).type;
-      numElems = drgn_type_length(variable.type);
-    } else {
-      drgn_utils::getDrgnArrayElementType(variable.type, &arrayElementType,
-                                          numElems);
-    }
-    assert(numElems > 0);
-    elementTypes.push_back(
-        drgn_qualified_type{arrayElementType, (enum drgn_qualifiers)(0)});
+    elementTypes = {&desc.arrayElementType, 1};
   } else {
-    auto entry = th->containerTypeMap.find(variable.type);
-    if (entry == th->containerTypeMap.end()) {
+    const auto* container = desc.container;
+    if (container == nullptr) {
       throw std::runtime_error(
           "Could not find container information for type with name '" +
-          node.typeName + "'");
+          std::string{node.typeName} + "'");
     }
 
-    auto& [containerKind, templateTypes] = entry->second;
+    auto& [containerKind, templateTypes] = *container;
     kind = containerKind;
-    for (const auto& tt : templateTypes) {
-      elementTypes.push_back(tt);
-    }
+    elementTypes = templateTypes;
   }
 
   /**
@@ -620,7 +965,7 @@ void TreeBuilder::processContainer(const Variable& variable, Node& node) {
       node.containerStats.emplace(Node::ContainerStats{0, 0, 0});
 
   for (auto& type : elementTypes) {
-    containerStats.elementStaticSize += getDrgnTypeSize(type.type);
+    containerStats.elementStaticSize += getTypeDesc(type.type).staticSize;
   }
 
   switch (kind) {
@@ -667,28 +1012,17 @@ void TreeBuilder::processContainer(const Variable& variable, Node& node) {
     case CONTAINER_ADAPTER_TYPE: {
       node.pointer = next();
 
-      // Copy the underlying container's sizes and stats directly into this
-      // container adapter
-      node.children = {nextNodeID, nextNodeID + 1};
-      nextNodeID += 1;
-      auto childID = node.children->first;
       // elementTypes is only populated with the underlying container type for
       // container adapters
-      auto containerType = elementTypes[0];
-      auto child = process(
-          childID++, {.type = containerType.type,
-                      .name = "",
-                      .typePath = drgnTypeToName(containerType.type) + "[]"});
-
-      setSize(node, child.dynamicSize, child.dynamicSize + child.staticSize);
-      node.containerStats = child.containerStats;
+      frame.setChildren(Frame::Kind::ContainerAdapter, 1, nextNodeID);
+      frame.elementTypes = elementTypes.first(1);
       return;
     }
     case STD_VARIANT_TYPE: {
       containerStats.length = containerStats.capacity = 1;
       containerStats.elementStaticSize = 0;
       for (auto& type : elementTypes) {
-        auto paramSize = getDrgnTypeSize(type.type);
+        auto paramSize = getTypeDesc(type.type).staticSize;
         containerStats.elementStaticSize =
             std::max(containerStats.elementStaticSize, paramSize);
       }
@@ -710,17 +1044,8 @@ void TreeBuilder::processContainer(const Variable& variable, Node& node) {
       if (auto index = next(); index < elementTypes.size()) {
         // Recurse only into the type of the template parameter which
         // is currently stored in this variant
-        node.children = {nextNodeID, nextNodeID + 1};
-        nextNodeID += 1;
-        auto childID = node.children->first;
-
-        auto elementType = elementTypes[index];
-        auto child = process(
-            childID++, {.type = elementType.type,
-                        .name = "",
-                        .typePath = drgnTypeToName(elementType.type) + "[]"});
-
-        setSize(node, child.dynamicSize, child.dynamicSize + child.staticSize);
+        frame.setChildren(Frame::Kind::Variant, 1, nextNodeID);
+        frame.elementTypes = elementTypes.subspan(index, 1);
       }
       return;
     }
@@ -878,9 +1203,9 @@ void TreeBuilder::processContainer(const Variable& variable, Node& node) {
         "Container size exceeds threshold, this is likely due to reading "
         "uninitialized data in the target process");
   }
-  if (std::ranges::all_of(
-          elementTypes.cbegin(), elementTypes.cend(),
-          [this](auto& type) { return isPrimitive(type.type); })) {
+  if (std::ranges::all_of(elementTypes, [this](auto& type) {
+        return getTypeDesc(type.type).isPrimitive;
+      })) {
     VLOG(1)
         << "Container [" << node.id
         << "] contains only primitive types, skipping processing its members";
@@ -892,23 +1217,81 @@ void TreeBuilder::processContainer(const Variable& variable, Node& node) {
     VLOG(1) << "Container [" << node.id << "] has no children";
     return;
   }
-  node.children = {nextNodeID, nextNodeID + numChildren};
+
+  if (config.aggregateElements && containerStats.length > 1 &&
+      std::ranges::all_of(elementTypes, [this](auto& type) {
+        return getTypeDesc(type.type).isStaticOnly;
+      })) {
+    VLOG(1) << "Container [" << node.id << "]'s " << containerStats.length
+            << " elements are summarised";
+    node.children = {nextNodeID, nextNodeID + elementTypes.size()};
+    nextNodeID += elementTypes.size();
+    auto childID = node.children->first;
+    uint64_t memberSizes = 0;
+    for (auto& type : elementTypes) {
+      auto child = processSummary(childID++, getTypeDesc(type.type),
+                                  containerStats.length);
+      memberSizes += child.staticSize;
+    }
+    setSize(node, node.dynamicSize, memberSizes);
+    return;
+  }
+
+  frame.setChildren(Frame::Kind::Elements, numChildren, nextNodeID);
+  frame.elementTypes = elementTypes;
   VLOG(1) << "Container [" << node.id << "]'s children cover range ["
           << node.children->first << ", " << node.children->second << ")";
-  nextNodeID += numChildren;
-  auto childID = node.children->first;
-  uint64_t memberSizes = 0;
-  for (size_t i = 0; i < containerStats.length; i++) {
-    for (auto& type : elementTypes) {
-      auto child =
-          process(childID++, {.type = type.type,
-                              .name = "",
-                              .typePath = drgnTypeToName(type.type) + "[]"});
-      node.dynamicSize += child.dynamicSize;
-      memberSizes += child.dynamicSize + child.staticSize;
+}
+
+/*
+ * Store a single node standing in for `count` elements of the given type, in
+ * place of processing each of them. Only valid for static-only types, which
+ * have no dynamic size and read nothing from the data segment.
+ */
+TreeBuilder::Node TreeBuilder::processSummary(NodeID id,
+                                              const TypeDesc& desc,
+                                              size_t count) {
+  Node node{
+      .id = id,
+      .typeName = desc.name,
+      .typePath = desc.elementTypePath,
+      .staticSize = desc.staticSize * count,
+      .aggregateCount = count,
+  };
+  setSize(node, 0, 0);
+
+  if (desc.padding != nullptr) {
+    node.paddingSavingsSize = desc.padding->savingSize * count;
+  }
+  if (config.features[Feature::GenPaddingStats]) {
+    countPaddedInstances(desc, count);
+  }
+
+  storeNode(node);
+  return node;
+}
+
+/*
+ * Account for the padded structs `process` would have found within `count`
+ * nodes of the given static-only type.
+ */
+void TreeBuilder::countPaddedInstances(const TypeDesc& desc, size_t count) {
+  if (desc.padding != nullptr) {
+    desc.padding->instancesCnt += count;
+  }
+
+  if (desc.kind == DRGN_TYPE_TYPEDEF) {
+    if (!desc.isStandardInteger && desc.target != nullptr) {
+      countPaddedInstances(getTypeDesc(desc.target), count);
+    }
+  } else if (!desc.isDummy && desc.members != nullptr &&
+             (desc.kind == DRGN_TYPE_CLASS || desc.kind == DRGN_TYPE_STRUCT)) {
+    for (const auto& member : *desc.members) {
+      if (!member.isStubbed) {
+        countPaddedInstances(getTypeDesc(member.type), count);
+      }
     }
   }
-  setSize(node, node.dynamicSize, memberSizes);
 }
 
 template <class T>
@@ -922,21 +1305,64 @@ std::string_view TreeBuilder::serialize(const T& data) {
 
 void TreeBuilder::JSON(NodeID id, std::ofstream& output) {
   std::string data;
-  auto status = db->Get(rocksdb::ReadOptions(), std::to_string(id), &data);
-  if (!status.ok()) {
-    throw std::runtime_error("RocksDB error while reading node [" +
-                             std::to_string(id) + "]: " + status.ToString());
-  }
-
+  msgpack::object_handle unpacked;
   Node node;
-  msgpack::unpack(data.data(), data.size()).get().convert(node);
+  if (nodeFile) {
+    using nodefile::NodeRecord;
+
+    auto record = nodeFile->read(id);
+    node = Node{
+        .id = record.id,
+        .name = nodeFile->getString(record.name),
+        .typeName = nodeFile->getString(record.typeName),
+        .typePath = nodeFile->getString(record.typePath),
+        .isTypedef = record.has(NodeRecord::IsTypedef),
+        .staticSize = record.staticSize,
+        .dynamicSize = record.dynamicSize,
+        .exclusiveSize = record.exclusiveSize,
+    };
+    if (record.has(NodeRecord::HasPaddingSavingsSize)) {
+      node.paddingSavingsSize = record.paddingSavingsSize;
+    }
+    if (record.has(NodeRecord::HasPointer)) {
+      node.pointer = record.pointer;
+    }
+    if (record.has(NodeRecord::HasContainerStats)) {
+      node.containerStats = Node::ContainerStats{
+          record.length, record.capacity, record.elementStaticSize};
+    }
+    if (record.has(NodeRecord::HasChildren)) {
+      node.children = {record.childrenStart, record.childrenEnd};
+    }
+    if (record.has(NodeRecord::HasIsset)) {
+      node.isset = record.has(NodeRecord::Isset);
+    }
+    if (record.has(NodeRecord::HasAggregateCount)) {
+      node.aggregateCount = record.aggregateCount;
+    }
+  } else {
+    auto key = nodeKey(id);
+    auto status = db->Get(rocksdb::ReadOptions(),
+                          rocksdb::Slice{key.data(), key.size()}, &data);
+    if (!status.ok()) {
+      throw std::runtime_error("RocksDB error while reading node [" +
+                               std::to_string(id) +
+                               "]: " + status.ToString());
+    }
+
+    // The node's strings point into the unpacked object, keep it alive
+    unpacked = msgpack::unpack(data.data(), data.size());
+    unpacked.get().convert(node);
+  }
   // Remove all backslashes to ensure the output is valid JSON
-  std::replace(node.typePath.begin(), node.typePath.end(), '\\', ' ');
-  std::replace(node.typeName.begin(), node.typeName.end(), '\\', ' ');
+  std::string typePath{node.typePath};
+  std::string typeName{node.typeName};
+  std::replace(typePath.begin(), typePath.end(), '\\', ' ');
+  std::replace(typeName.begin(), typeName.end(), '\\', ' ');
   output << "{";
   output << "\"name\":\"" << node.name << "\",";
-  output << "\"typePath\":\"" << node.typePath << "\",";
-  output << "\"typeName\":\"" << node.typeName << "\",";
+  output << "\"typePath\":\"" << typePath << "\",";
+  output << "\"typeName\":\"" << typeName << "\",";
   output << "\"isTypedef\":" << (node.isTypedef ? "true" : "false") << ",";
   output << "\"staticSize\":" << node.staticSize << ",";
   output << "\"dynamicSize\":" << node.dynamicSize << ",";
@@ -960,6 +1386,10 @@ void TreeBuilder::JSON(NodeID id, std::ofstream& output) {
     output << ",";
     output << "\"isset\":" << (*node.isset ? "true" : "false");
   }
+  if (node.aggregateCount.has_value()) {
+    output << ",";
+    output << "\"aggregateCount\":" << *node.aggregateCount;
+  }
   if (node.children.has_value()) {
     output << ",";
     output << "\"members\":[";
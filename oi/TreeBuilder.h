@@ -20,9 +20,11 @@
 #include <optional>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "oi/DataSegmentCursor.h"
 #include "oi/Features.h"
 #include "oi/TypeHierarchy.h"
 
@@ -31,6 +33,11 @@
 // pay the cost of including the relevant headers.
 namespace rocksdb {
 class DB;
+class WriteBatch;
+}
+
+namespace oi::detail::nodefile {
+class NodeFileWriter;
 }
 
 // Forward declared, comes from PaddingInfo.h
@@ -48,6 +55,16 @@ class TreeBuilder {
     bool dumpDataSegment;
     std::optional<std::string> jsonPath;
     bool strict;
+    // Write the nodes to a columnar node file at this path instead of the
+    // RocksDB database. See oi/NodeFile.h for the format.
+    std::optional<std::string> nodeFilePath;
+    // The RocksDB database to write the nodes to, when not writing a node
+    // file. Defaults to /tmp/testdb_<pid>.
+    std::optional<std::string> dbPath;
+    // Collapse the elements of a container into a single summary node per
+    // element type when none of them has a dynamic size, rather than storing
+    // one node per element.
+    bool aggregateElements;
   };
 
   TreeBuilder(Config);
@@ -57,6 +74,10 @@ class TreeBuilder {
              const std::string&,
              struct drgn_type*,
              const TypeHierarchy&);
+  void build(DataSegmentCursor,
+             const std::string&,
+             struct drgn_type*,
+             const TypeHierarchy&);
   void dumpJson();
   void setPaddedStructs(std::map<std::string, PaddingInfo>* paddedStructs);
   bool emptyOutput() const;
@@ -67,22 +88,64 @@ class TreeBuilder {
   struct DBHeader;
   struct Node;
   struct Variable;
+  struct Frame;
+
+  /*
+   * Everything `process` needs to know about a type that doesn't depend on
+   * the data being processed. Nodes of the same type are very common (e.g.
+   * the elements of a container), so this is worked out once per type and
+   * `build` rather than once per node.
+   */
+  struct TypeDesc {
+    std::string name;
+    /* Type path of container elements of this type */
+    std::string elementTypePath;
+    uint64_t staticSize;
+    enum drgn_type_kind kind;
+    bool isDummy;
+    bool isPrimitive;
+    /* Typedefs of well-known integer types, which aren't expanded */
+    bool isStandardInteger;
+    bool isContainer;
+    bool captureThriftIsset;
+    /*
+     * Nodes of this type are described entirely by their static size, so
+     * processing them reads nothing from the data segment. Only worked out
+     * when aggregating elements.
+     */
+    bool isStaticOnly;
+    /* Typedef'd or pointed-to type, if known */
+    struct drgn_type* target;
+    const std::vector<DrgnClassMemberInfo>* members;
+    const std::vector<struct drgn_type*>* descendants;
+    const std::pair<ContainerTypeEnum, std::vector<drgn_qualified_type>>*
+        container;
+    /* Element type of array containers, kept here so it can be referenced */
+    struct drgn_qualified_type arrayElementType;
+    PaddingInfo* padding;
+  };
 
   const TypeHierarchy* th = nullptr;
-  const std::vector<uint64_t>* oidData = nullptr;
+  DataSegmentCursor* oidData = nullptr;
   std::map<std::string, PaddingInfo>* paddedStructs = nullptr;
+  std::unordered_map<struct drgn_type*, TypeDesc> typeDescs;
 
   /*
    * The RocksDB output needs versioning so they are imported correctly in
    * Scuba. Version 1 had no concept of versioning and no header.
-   * We currently are at version 2.1:
+   * We currently are at version 3:
+   *  - Key the nodes by their ID as a fixed-width, big-endian integer rather
+   *    than a decimal string, so that the keys sort in ID order
+   *  - Introduce `aggregateCount` for the summary nodes of containers, only
+   *    output when aggregating elements
+   * Changelog v2.1:
    *  - Introduce the Error ID at index 1023, but don't output it
    * Changelog v2:
    *  - Introduce the DBHeader at index 0
    *  - Introduce the versioning
    *  - Handle multiple root_ids, to import multiple objects in Scuba
    */
-  static constexpr Version VERSION = 2;
+  static constexpr Version VERSION = 3;
   static constexpr NodeID ROOT_NODE_ID = 0;
   static constexpr NodeID ERROR_NODE_ID = 1023;
   static constexpr NodeID FIRST_NODE_ID = 1024;
@@ -95,7 +158,6 @@ class TreeBuilder {
   NodeID nextNodeID = FIRST_NODE_ID;
 
   const Config config{};
-  size_t oidDataIndex;
 
   std::vector<NodeID> rootIDs{};
 
@@ -105,15 +167,31 @@ class TreeBuilder {
    */
   std::unique_ptr<msgpack::sbuffer> buffer;
   rocksdb::DB* db = nullptr;
+  /*
+   * Nodes waiting to be written to `db`. Writing them in batches is much
+   * cheaper than a `Put` per node.
+   */
+  std::unique_ptr<rocksdb::WriteBatch> batch;
+  std::unique_ptr<nodefile::NodeFileWriter> nodeFile;
 
   uint64_t getDrgnTypeSize(struct drgn_type* type);
+  const TypeDesc& getTypeDesc(struct drgn_type* type);
   uint64_t next();
-  bool isContainer(const Variable& variable);
+  bool isContainer(struct drgn_type* type);
   bool isPrimitive(struct drgn_type* type);
+  bool isStaticOnly(const TypeDesc& desc);
   Node process(NodeID id, Variable variable);
-  void processContainer(const Variable& variable, Node& node);
+  Frame startNode(NodeID id, const Variable& variable);
+  std::pair<NodeID, Variable> nextChild(Frame& frame);
+  void addChild(Frame& frame, const Node& child);
+  Node finishNode(Frame& frame);
+  void processContainer(const Variable& variable, Frame& frame);
+  Node processSummary(NodeID id, const TypeDesc& desc, size_t count);
+  void countPaddedInstances(const TypeDesc& desc, size_t count);
   template <class T>
   std::string_view serialize(const T&);
+  void storeNode(const Node&);
+  void writeBatch();
   void JSON(NodeID id, std::ofstream& output);
 
   static void setSize(TreeBuilder::Node& node,
@@ -52,11 +52,11 @@ void Json::print(const IntrospectionResult& r) {
 
 void Json::print(IntrospectionResult::const_iterator& it,
                  IntrospectionResult::const_iterator end) {
-  std::vector<std::string_view> firstTypePath = it->type_path;
+  size_t firstTypePathSize = it->type_path.size();
 
-  const auto indent = pretty_ ? makeIndent(firstTypePath.size()) : "";
+  const auto indent = pretty_ ? makeIndent(firstTypePathSize) : "";
   const auto lastIndent =
-      pretty_ ? makeIndent(std::max(firstTypePath.size(), 1UL) - 1) : "";
+      pretty_ ? makeIndent(std::max(firstTypePathSize, 1UL) - 1) : "";
   const auto* tab = pretty_ ? "  " : "";
   const auto* space = pretty_ ? " " : "";
   const auto* endl = pretty_ ? "\n" : "";
@@ -65,7 +65,7 @@ void Json::print(IntrospectionResult::const_iterator& it,
 
   bool first = true;
   while (it != end) {
-    if (it->type_path.size() < firstTypePath.size()) {
+    if (it->type_path.size() < firstTypePathSize) {
       // no longer a sibling, must be a sibling of the type we're printing
       break;
     }
@@ -107,6 +107,11 @@ void Json::print(IntrospectionResult::const_iterator& it,
            << ',' << endl
            << indent;
     }
+    if (it->aggregate_count.has_value()) {
+      out_ << tab << "\"aggregateCount\":" << space << *(it->aggregate_count)
+           << ',' << endl
+           << indent;
+    }
     if (it->is_set_stats.has_value()) {
       out_ << tab << "\"is_set\":" << space << it->is_set_stats->is_set << ','
            << endl
@@ -114,7 +119,7 @@ void Json::print(IntrospectionResult::const_iterator& it,
     }
 
     out_ << tab << "\"members\":" << space;
-    if (++it != end && it->type_path.size() > firstTypePath.size()) {
+    if (++it != end && it->type_path.size() > firstTypePathSize) {
       print(it, end);
     } else {
       out_ << "[]" << endl;
@@ -122,7 +127,7 @@ void Json::print(IntrospectionResult::const_iterator& it,
 
     out_ << indent << "}";
   }
-  if (firstTypePath.size() == 1) {
+  if (firstTypePathSize == 1) {
     out_ << endl << ']' << endl;
   } else {
     out_ << endl << lastIndent << tab << ']' << endl;
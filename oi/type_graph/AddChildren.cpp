@@ -59,12 +59,12 @@ void AddChildren::visit(Class& c) {
     accept(member.type());
   }
 
-  if (!c.isDynamic()) {
+  if (!c.isDynamic() || childClasses_ == nullptr) {
     return;
   }
 
-  auto it = childClasses_.find(c.name());
-  if (it == childClasses_.end()) {
+  auto it = childClasses_->find(c.name());
+  if (it == childClasses_->end()) {
     return;
   }
 
@@ -105,7 +105,8 @@ void AddChildren::visit(Class& c) {
   }
 }
 
-void AddChildren::recordChildren(drgn_type* type) {
+void AddChildren::recordChildren(drgn_type* type,
+                                 SymbolService::ChildClasses& childClasses) {
   drgn_type_template_parameter* parents = drgn_type_parents(type);
 
   for (size_t i = 0; i < drgn_type_num_parents(type); i++) {
@@ -141,9 +142,10 @@ void AddChildren::recordChildren(drgn_type* type) {
      *
      * Use unqualified names because fully-qualified names are too slow. We'll
      * check against fully-qualified names once we've narrowed down the number
-     * of types to compare.
+     * of types to compare. The names are owned by drgn, so they don't need to
+     * be copied.
      */
-    childClasses_[parentName].push_back(type);
+    childClasses[parentName].push_back(type);
   }
 }
 
@@ -152,14 +154,23 @@ void AddChildren::recordChildren(drgn_type* type) {
  *
  * drgn only gives us the mapping Class -> Parents, so we must iterate over all
  * types in the program to build the reverse mapping.
+ *
+ * The mapping is kept by the SymbolService and reused by later passes over the
+ * same program. drgn isn't thread-safe, so the scan itself stays serial.
  */
 void AddChildren::enumerateChildClasses(SymbolService& symbols) {
+  if (symbols.childClasses.has_value()) {
+    childClasses_ = &*symbols.childClasses;
+    return;
+  }
+
   if ((setenv("DRGN_ENABLE_TYPE_ITERATOR", "1", 1)) < 0) {
     //    LOG(ERROR)
     //        << "Could not set DRGN_ENABLE_TYPE_ITERATOR environment variable";
     abort();
   }
 
+  SymbolService::ChildClasses childClasses;
   drgn_type_iterator* typesIterator;
   auto* prog = symbols.getDrgnProgram();
   drgn_error* err = drgn_type_iterator_create(prog, &typesIterator);
@@ -192,10 +203,12 @@ void AddChildren::enumerateChildClasses(SymbolService& symbols) {
       continue;
     }
 
-    recordChildren(t->type);
+    recordChildren(t->type, childClasses);
   }
 
   drgn_type_iterator_destroy(typesIterator);
+
+  childClasses_ = &symbols.childClasses.emplace(std::move(childClasses));
 }
 
 }  // namespace oi::detail::type_graph
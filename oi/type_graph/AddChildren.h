@@ -22,11 +22,9 @@
 #include "PassManager.h"
 #include "Types.h"
 #include "Visitor.h"
+#include "oi/SymbolService.h"
 
 struct drgn_type;
-namespace oi::detail {
-class SymbolService;
-}
 
 namespace oi::detail::type_graph {
 
@@ -64,7 +62,8 @@ class AddChildren final : public RecursiveVisitor {
   void enumerateClassChildren(
       struct drgn_type* type,
       std::vector<std::reference_wrapper<Class>>& children);
-  void recordChildren(drgn_type* type);
+  static void recordChildren(drgn_type* type,
+                             SymbolService::ChildClasses& childClasses);
 
   std::unordered_set<Type*> visited_;
   TypeGraph& typeGraph_;
@@ -72,8 +71,8 @@ class AddChildren final : public RecursiveVisitor {
 
   // Mapping of parent classes to child classes, using names for keys, as drgn
   // pointers returned from a type iterator will not match those returned from
-  // enumerating types in the normal way.
-  std::unordered_map<std::string, std::vector<drgn_type*>> childClasses_;
+  // enumerating types in the normal way. Owned by the SymbolService.
+  const SymbolService::ChildClasses* childClasses_ = nullptr;
 };
 
 }  // namespace oi::detail::type_graph
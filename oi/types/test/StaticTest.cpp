@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 
+#include <cstdint>
+#include <vector>
+
 #define DEFINE_DESCRIBE 1
 #include "oi/types/dy.h"
 #include "oi/types/st.h"
@@ -8,6 +11,47 @@ using namespace oi;
 
 class DummyDataBuffer {};
 
+/* A DataBuffer without the optional bulk write methods */
+class ByteDataBuffer {
+ public:
+  ByteDataBuffer(std::vector<uint8_t>& v) : buf(&v) {
+  }
+
+  void write_byte(uint8_t byte) {
+    buf->push_back(byte);
+  }
+
+ private:
+  std::vector<uint8_t>* buf;
+};
+
+/* A DataBuffer with the bulk write methods, recording their use */
+class BulkDataBuffer {
+ public:
+  struct State {
+    std::vector<uint8_t> bytes;
+    size_t bulkWrites = 0;
+    size_t reserved = 0;
+  };
+
+  BulkDataBuffer(State& s) : state(&s) {
+  }
+
+  void write_byte(uint8_t byte) {
+    state->bytes.push_back(byte);
+  }
+  void write_bytes(const uint8_t* bytes, size_t n) {
+    state->bytes.insert(state->bytes.end(), bytes, bytes + n);
+    state->bulkWrites++;
+  }
+  void reserve(size_t n) {
+    state->reserved += n;
+  }
+
+ private:
+  State* state;
+};
+
 TEST(StaticTypes, TestUnitToDynamic) {
   // ASSIGN
   using ty = types::st::Unit<DummyDataBuffer>;
@@ -102,3 +146,48 @@ TEST(StaticTypes, TestListToDynamic) {
       std::holds_alternative<std::reference_wrapper<const types::dy::VarInt>>(
           listType.element));
 }
+
+TEST(StaticTypes, TestVarIntBulkWrite) {
+  for (uint64_t val : {0ul, 0x7ful, 0x80ul, 0x3fffful, UINT64_MAX}) {
+    std::vector<uint8_t> expected;
+    types::st::VarInt<ByteDataBuffer>{ByteDataBuffer{expected}}.write(val);
+
+    BulkDataBuffer::State state;
+    types::st::VarInt<BulkDataBuffer>{BulkDataBuffer{state}}.write(val);
+
+    EXPECT_EQ(state.bytes, expected) << "value " << val;
+    EXPECT_EQ(state.bulkWrites, 1);
+    EXPECT_LE(state.bytes.size(), types::st::VarInt<BulkDataBuffer>::maxSize);
+  }
+}
+
+TEST(StaticTypes, TestMaxSize) {
+  using DB = DummyDataBuffer;
+  using unit = types::st::Unit<DB>;
+  using varint = types::st::VarInt<DB>;
+
+  EXPECT_EQ(unit::maxSize, 0);
+  EXPECT_EQ(varint::maxSize, 10);
+  EXPECT_EQ((types::st::Pair<DB, varint, varint>::maxSize), 20);
+  EXPECT_EQ((types::st::Sum<DB, unit, varint>::maxSize), 20);
+  EXPECT_EQ((types::st::List<DB, varint>::maxSize), types::st::unboundedSize);
+  EXPECT_EQ((types::st::Pair<DB, varint, types::st::List<DB, varint>>::maxSize),
+            types::st::unboundedSize);
+}
+
+TEST(StaticTypes, TestListReserve) {
+  using DB = BulkDataBuffer;
+
+  { /* Bounded elements reserve their maximum size */
+    BulkDataBuffer::State state;
+    types::st::List<DB, types::st::VarInt<DB>>{BulkDataBuffer{state}}.write(5);
+    EXPECT_EQ(state.reserved, 5 * types::st::VarInt<DB>::maxSize);
+  }
+
+  { /* Unbounded elements don't reserve */
+    BulkDataBuffer::State state;
+    using inner = types::st::List<DB, types::st::VarInt<DB>>;
+    types::st::List<DB, inner>{BulkDataBuffer{state}}.write(5);
+    EXPECT_EQ(state.reserved, 0);
+  }
+}
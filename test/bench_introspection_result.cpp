@@ -0,0 +1,99 @@
+/*
+ * Measure how fast IntrospectionResult walks a large result: a synthetic
+ * std::vector<std::vector<int>> is iterated element by element, both with and
+ * without aggregated elements.
+ *
+ * Usage: bench_introspection_result [outer length] [inner length]
+ */
+#include <oi/IntrospectionResult.h>
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace oi;
+using exporters::ParsedData;
+namespace inst = exporters::inst;
+
+namespace {
+
+constexpr std::array<inst::Field, 0> noFields{};
+constexpr std::array<inst::ProcessorInst, 0> noProcessors{};
+
+constexpr types::dy::Unit unitType{};
+constexpr types::dy::List listType{unitType};
+
+template <const inst::Field& Element>
+void processVector(result::Element& el, inst::Stack& stack_ins, ParsedData d) {
+  auto list = std::get<ParsedData::List>(d.val);
+  el.container_stats.emplace(result::Element::ContainerStats{
+      .capacity = list.length, .length = list.length});
+  for (size_t i = 0; i < list.length; i++)
+    stack_ins(Element);
+}
+
+template <const inst::Field& Element>
+constexpr std::array<inst::ProcessorInst, 1> vectorProcessors{
+    inst::ProcessorInst{listType, &processVector<Element>},
+};
+
+constexpr std::array<std::string_view, 1> intNames{"int"};
+constexpr inst::Field intElement{sizeof(int), "[]", intNames, noFields,
+                                 noProcessors};
+
+constexpr std::array<std::string_view, 1> innerNames{"std::vector<int>"};
+constexpr inst::Field innerVector{24, "[]", innerNames, noFields,
+                                  vectorProcessors<intElement>};
+
+constexpr std::array<std::string_view, 1> outerNames{
+    "std::vector<std::vector<int>>"};
+constexpr inst::Field outerVector{24, "v", outerNames, noFields,
+                                  vectorProcessors<innerVector>};
+
+void writeVarint(std::vector<uint8_t>& buf, uint64_t val) {
+  while (val >= 0x80) {
+    buf.push_back(static_cast<uint8_t>(val) | 0x80);
+    val >>= 7;
+  }
+  buf.push_back(static_cast<uint8_t>(val));
+}
+
+void bench(const std::vector<uint8_t>& buf, bool aggregate) {
+  using clock = std::chrono::steady_clock;
+
+  IntrospectionResult result{std::cref(buf), outerVector};
+  result.setAggregateElements(aggregate);
+
+  size_t elements = 0;
+  size_t depth = 0;
+  auto start = clock::now();
+  for (const auto& el : result) {
+    elements++;
+    depth += el.type_path.size();
+  }
+  std::chrono::duration<double> time = clock::now() - start;
+
+  std::cout << (aggregate ? "aggregated" : "  complete") << std::fixed
+            << std::setprecision(1) << "  " << elements << " elements in "
+            << time.count() * 1000 << " ms: "
+            << elements / time.count() / 1e6 << "M elements/s (mean depth "
+            << static_cast<double>(depth) / elements << ")" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  size_t outer = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  size_t inner = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 9;
+
+  std::vector<uint8_t> buf;
+  writeVarint(buf, outer);
+  for (size_t i = 0; i < outer; i++)
+    writeVarint(buf, inner);
+
+  bench(buf, false);
+  bench(buf, true);
+}
@@ -0,0 +1,84 @@
+/*
+ * Compare OIL's JIT optimisation levels: for each level, how long `init`
+ * takes to compile the introspection function and how fast `introspect` then
+ * traverses an object. Use it to pick `optimizationLevel` and
+ * `backgroundOptimizationLevel` in oi::GeneratorOptions.
+ *
+ * Usage: bench_oil_tiering [iterations]
+ */
+#include <oi/oi-jit.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+/*
+ * Each level needs its own type, as the compiled function is cached per
+ * CodegenHandler instantiation.
+ */
+template <int Level>
+struct Object {
+  std::vector<std::string> strings;
+  std::map<int, std::vector<int>> map;
+};
+
+template <int Level>
+Object<Level> makeObject() {
+  Object<Level> obj;
+  for (int i = 0; i < 1000; i++) {
+    obj.strings.push_back("string number " + std::to_string(i));
+    obj.map[i] = std::vector<int>(i % 16, i);
+  }
+  return obj;
+}
+
+template <int Level>
+void bench(size_t iterations) {
+  using clock = std::chrono::steady_clock;
+  using Handler = oi::CodegenHandler<Object<Level>>;
+
+  auto obj = makeObject<Level>();
+  oi::GeneratorOptions opts{
+      .configFilePath = CONFIG_FILE_PATH,
+      .optimizationLevel = Level,
+  };
+
+  auto start = clock::now();
+  if (!Handler::init(opts)) {
+    std::cerr << "failed to initialise level " << Level << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  std::chrono::duration<double, std::milli> compileTime = clock::now() - start;
+
+  std::vector<uint8_t> buf;
+  size_t bytes = 0;
+  start = clock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    Handler::introspect(obj, buf);
+    bytes += buf.size();
+  }
+  std::chrono::duration<double> traversalTime = clock::now() - start;
+
+  std::cout << "-O" << Level << std::fixed << std::setprecision(1)
+            << "  compile: " << compileTime.count() << " ms"
+            << "  introspect: " << iterations / traversalTime.count()
+            << " objects/s (" << bytes / iterations << " bytes each)"
+            << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+
+  bench<0>(iterations);
+  bench<1>(iterations);
+  bench<2>(iterations);
+  bench<3>(iterations);
+}
@@ -1,5 +1,6 @@
 import glob
 import json
+import logging
 import os
 import os.path
 import shutil
@@ -303,6 +304,39 @@ class OIDebuggerTestCase(unittest.TestCase):
         with open("oid_metrics.json", "r") as f:
             json.loads(f.read())
 
+    def test_warm_cache_run(self):
+        cache_path = os.path.join(self.temp.name, "oid-cache")
+        os.mkdir(cache_path)
+
+        durations = []
+        for _ in range(2):
+            start = time.monotonic()
+            with self.spawn_oid(
+                self.script(), oid_opt=f"--cache-path {cache_path}"
+            ) as proc:
+                self.expectReturncode(proc, ExitStatus.SUCCESS)
+            durations.append(time.monotonic() - start)
+
+        # Timings depend on the machine's load, they are only reported
+        cold, warm = durations
+        logging.getLogger(__name__).info(
+            "cold cache: %.2fs, warm cache: %.2fs", cold, warm
+        )
+
+        # The warm run loads the cached probe instead of generating and
+        # compiling it, so the compiler's object cache isn't even looked up
+        with open("oid_metrics.counters.json", "r") as f:
+            counters = json.loads(f.read())
+            self.assertGreater(counters.get("probe_cache_hit", 0), 0)
+            self.assertNotIn("object_cache_hit", counters)
+        with open("oid_metrics.json", "r") as f:
+            spans = json.loads(f.read())
+            self.assertNotIn("compile", [span["name"] for span in spans])
+
+        with open(OUTPUT_PATH, "r") as f:
+            output = json.loads(f.read())
+            self.assertEqual(output[0]["typeName"], "Foo")
+
     # Ensure removeTrap properly repatch small functions
     def test_probe_return_arg0_small_fun(self):
         # Check function incN is smaller than the POKETEXT window (8 bytes)
@@ -175,3 +175,14 @@ TEST_F(AddChildrenTest, InheritancePolymorphic) {
                  Function: myfunc (virtual)
 )");
 }
+
+TEST_F(AddChildrenTest, ChildClassesAreKept) {
+  // The expensive scan of every type is kept by the SymbolService
+  run("oid_test_case_inheritance_polymorphic_a_as_a", {});
+  ASSERT_TRUE(symbols_->childClasses.has_value());
+  EXPECT_TRUE(symbols_->childClasses->contains("A"));
+
+  const auto* childClasses = &*symbols_->childClasses;
+  run("oid_test_case_inheritance_polymorphic_a_as_a", {});
+  EXPECT_EQ(&*symbols_->childClasses, childClasses);
+}
@@ -6,6 +6,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <filesystem>
+#include <fstream>
 
 #include "oi/OICompiler.h"
 
@@ -165,6 +166,104 @@ TEST(CompilerTest, CompileAndRelocateMultipleObjs) {
   munmap(relocSlab, relocSlabSize);
 }
 
+TEST(CompilerTest, ObjectCache) {
+  auto symbols = std::make_shared<SymbolService>(getpid());
+
+  auto code = R"(
+    extern "C" int constant() { return 42; }
+  )";
+
+  auto tmpdir = fs::temp_directory_path() / "test-XXXXXX";
+  EXPECT_NE(mkdtemp(const_cast<char*>(tmpdir.c_str())), nullptr);
+
+  auto sourcePath = tmpdir / "src.cpp";
+  auto cacheDir = tmpdir / "objects";
+
+  OICompiler compiler{symbols, {.objectCacheDir = cacheDir}};
+  auto key = compiler.objectCacheKey(code, sourcePath);
+  auto cachedObject = cacheDir / (key + ".o");
+
+  EXPECT_TRUE(compiler.compile(code, sourcePath, tmpdir / "obj1.o"));
+  ASSERT_TRUE(fs::exists(cachedObject));
+  EXPECT_EQ(fs::file_size(cachedObject), fs::file_size(tmpdir / "obj1.o"));
+
+  { /* Different code or config must not share the same object */
+    EXPECT_NE(compiler.objectCacheKey("int x;", sourcePath), key);
+
+    OICompiler picCompiler{symbols, {.usePIC = true}};
+    EXPECT_NE(picCompiler.objectCacheKey(code, sourcePath), key);
+  }
+
+  { /* A hit is served from the cache without running clang */
+    std::ofstream{cachedObject, std::ios::trunc} << "not an object";
+
+    auto objectPath = tmpdir / "obj2.o";
+    EXPECT_TRUE(compiler.compile(code, sourcePath, objectPath));
+
+    std::ifstream ifs{objectPath};
+    std::string content{std::istreambuf_iterator<char>(ifs), {}};
+    EXPECT_EQ(content, "not an object");
+  }
+
+  fs::remove_all(tmpdir);
+}
+
+TEST(CompilerTest, PrecompiledHeader) {
+  auto symbols = std::make_shared<SymbolService>(getpid());
+
+  std::string prelude = R"(
+    namespace {
+    int base() { return 40; }
+    }
+  )";
+  std::string code = prelude + std::string{OICompiler::preludeEnd} + R"(
+    extern "C" int constant() { return base() + 2; }
+  )";
+
+  auto tmpdir = fs::temp_directory_path() / "test-XXXXXX";
+  EXPECT_NE(mkdtemp(const_cast<char*>(tmpdir.c_str())), nullptr);
+
+  auto sourcePath = tmpdir / "src.cpp";
+  auto objectPath = tmpdir / "obj.o";
+  auto pchDir = tmpdir / "pch";
+
+  OICompiler compiler{symbols, {.precompiledHeaderDir = pchDir}};
+  auto pchPath = pchDir / (compiler.precompiledHeaderKey(prelude) + ".pch");
+
+  EXPECT_TRUE(compiler.compile(code, sourcePath, objectPath));
+  EXPECT_TRUE(fs::exists(pchPath));
+
+  { /* Code with the same prelude reuses the precompiled header */
+    auto otherCode = prelude + std::string{OICompiler::preludeEnd} + R"(
+      extern "C" int other() { return base(); }
+    )";
+    EXPECT_TRUE(compiler.compile(otherCode, sourcePath, tmpdir / "other.o"));
+    EXPECT_EQ(std::distance(fs::directory_iterator{pchDir},
+                            fs::directory_iterator{}),
+              1);
+  }
+
+  const size_t relocSlabSize = 4096;
+  void* relocSlab =
+      mmap(nullptr, relocSlabSize, PROT_READ | PROT_WRITE | PROT_EXEC,
+           MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+  EXPECT_NE(relocSlab, nullptr);
+
+  auto relocResult =
+      compiler.applyRelocs((uintptr_t)relocSlab, {objectPath}, {});
+  ASSERT_TRUE(relocResult.has_value());
+
+  auto& [_, segs, jitSymbols] = relocResult.value();
+  for (const auto& [Base, Reloc, Size] : segs)
+    std::memcpy((void*)Reloc, (void*)Base, Size);
+
+  auto symAddr = jitSymbols.at("constant");
+  EXPECT_EQ(((jitFunc)symAddr)(), 42);
+
+  munmap(relocSlab, relocSlabSize);
+  fs::remove_all(tmpdir);
+}
+
 TEST(CompilerTest, LocateOpcodes) {
   const std::array retInsts = {
       std::array{0xC2_b}, /* Return from near procedure, with immediate value */
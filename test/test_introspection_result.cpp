@@ -0,0 +1,225 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <oi/IntrospectionIndex.h>
+#include <oi/IntrospectionResult.h>
+#include <vector>
+
+using namespace oi;
+using exporters::ParsedData;
+namespace inst = exporters::inst;
+
+namespace {
+
+constexpr std::array<inst::Field, 0> noFields{};
+constexpr std::array<inst::ProcessorInst, 0> noProcessors{};
+
+constexpr types::dy::Unit unitType{};
+constexpr types::dy::List listType{unitType};
+
+constexpr std::array<std::string_view, 1> intNames{"int"};
+constexpr inst::Field intElement{sizeof(int), "[]", intNames, noFields,
+                                 noProcessors};
+
+constexpr std::array<std::string_view, 1> pointNames{"Point"};
+constexpr std::array<inst::Field, 2> pointFields{
+    inst::Field{sizeof(int), "x", intNames, noFields, noProcessors},
+    inst::Field{sizeof(int), "y", intNames, noFields, noProcessors},
+};
+constexpr inst::Field pointElement{2 * sizeof(int), "[]", pointNames,
+                                   pointFields, noProcessors};
+
+template <const inst::Field& Element>
+void processVector(result::Element& el, inst::Stack& stack_ins, ParsedData d) {
+  auto list = std::get<ParsedData::List>(d.val);
+  el.container_stats.emplace(result::Element::ContainerStats{
+      .capacity = list.length, .length = list.length});
+  for (size_t i = 0; i < list.length; i++)
+    stack_ins(Element);
+}
+
+template <const inst::Field& Element>
+constexpr std::array<inst::ProcessorInst, 1> vectorProcessors{
+    inst::ProcessorInst{listType, &processVector<Element>},
+};
+
+constexpr std::array<std::string_view, 1> intVectorNames{"std::vector<int>"};
+constexpr inst::Field intVector{24, "v", intVectorNames, noFields,
+                                vectorProcessors<intElement>};
+
+constexpr std::array<std::string_view, 1> pointVectorNames{
+    "std::vector<Point>"};
+constexpr inst::Field pointVector{24, "v", pointVectorNames, noFields,
+                                  vectorProcessors<pointElement>};
+
+constexpr inst::Field intVectorElement{24, "[]", intVectorNames, noFields,
+                                       vectorProcessors<intElement>};
+constexpr std::array<std::string_view, 1> nestedVectorNames{
+    "std::vector<std::vector<int>>"};
+constexpr inst::Field nestedVector{24, "v", nestedVectorNames, noFields,
+                                   vectorProcessors<intVectorElement>};
+
+static_assert(intElement.is_static_only);
+static_assert(pointElement.is_static_only);
+static_assert(!intVectorElement.is_static_only);
+
+// Elements only borrow their type path from the iterator, so keep a copy of
+// each path in `paths` for the element to refer to
+std::vector<result::Element> elements(
+    const IntrospectionResult& result,
+    std::deque<std::vector<std::string_view>>& paths) {
+  std::vector<result::Element> els;
+  for (const auto& el : result) {
+    const auto& path = paths.emplace_back(el.type_path.begin(),
+                                          el.type_path.end());
+    els.push_back(el);
+    els.back().type_path = path;
+  }
+  return els;
+}
+
+bool pathIs(std::span<const std::string_view> path,
+            std::initializer_list<std::string_view> expected) {
+  return std::ranges::equal(path, expected);
+}
+
+}  // namespace
+
+TEST(IntrospectionResultTest, EveryElementByDefault) {
+  IntrospectionResult result{std::vector<uint8_t>{3}, intVector};
+
+  std::deque<std::vector<std::string_view>> paths;
+  auto els = elements(result, paths);
+  ASSERT_EQ(els.size(), 4);
+  for (size_t i = 1; i < els.size(); i++) {
+    EXPECT_EQ(els[i].static_size, sizeof(int));
+    EXPECT_FALSE(els[i].aggregate_count.has_value());
+  }
+}
+
+TEST(IntrospectionResultTest, AggregatesStaticElements) {
+  IntrospectionResult result{std::vector<uint8_t>{3}, intVector};
+  result.setAggregateElements(true);
+
+  std::deque<std::vector<std::string_view>> paths;
+  auto els = elements(result, paths);
+  ASSERT_EQ(els.size(), 2);
+  EXPECT_EQ(els[0].name, "v");
+  EXPECT_EQ(els[0].container_stats->length, 3);
+
+  EXPECT_EQ(els[1].name, "[]");
+  EXPECT_TRUE(pathIs(els[1].type_path, {"v", "[]"}));
+  EXPECT_EQ(els[1].aggregate_count, 3);
+  EXPECT_EQ(els[1].static_size, 3 * sizeof(int));
+  EXPECT_EQ(els[1].exclusive_size, 3 * sizeof(int));
+}
+
+TEST(IntrospectionResultTest, AggregatesNestedFields) {
+  IntrospectionResult result{std::vector<uint8_t>{5}, pointVector};
+  result.setAggregateElements(true);
+
+  std::deque<std::vector<std::string_view>> paths;
+  auto els = elements(result, paths);
+  ASSERT_EQ(els.size(), 2);
+  EXPECT_EQ(els[1].type_names[0], "Point");
+  EXPECT_EQ(els[1].aggregate_count, 5);
+  EXPECT_EQ(els[1].static_size, 5 * 2 * sizeof(int));
+}
+
+TEST(IntrospectionResultTest, DynamicElementsAreKept) {
+  // An outer vector holding vectors of 1 and 2 ints
+  IntrospectionResult result{std::vector<uint8_t>{2, 1, 2}, nestedVector};
+  result.setAggregateElements(true);
+
+  std::deque<std::vector<std::string_view>> paths;
+  auto els = elements(result, paths);
+  ASSERT_EQ(els.size(), 5);
+  EXPECT_EQ(els[1].container_stats->length, 1);
+  EXPECT_FALSE(els[2].aggregate_count.has_value());
+  EXPECT_EQ(els[3].container_stats->length, 2);
+  EXPECT_EQ(els[4].aggregate_count, 2);
+  EXPECT_TRUE(pathIs(els[4].type_path, {"v", "[]", "[]"}));
+}
+
+TEST(IntrospectionResultTest, TypePathFollowsIterator) {
+  IntrospectionResult result{std::vector<uint8_t>{2}, intVector};
+
+  auto it = result.begin();
+  EXPECT_TRUE(pathIs(it->type_path, {"v"}));
+
+  auto old = it++;
+  EXPECT_TRUE(pathIs(old->type_path, {"v"}));
+  EXPECT_TRUE(pathIs(it->type_path, {"v", "[]"}));
+}
+
+TEST(IntrospectionIndexTest, Structure) {
+  // An outer vector holding vectors of 1 and 2 ints
+  IntrospectionResult result{std::vector<uint8_t>{2, 1, 2}, nestedVector};
+  IntrospectionIndex index{result};
+
+  ASSERT_EQ(index.size(), 6);
+  EXPECT_EQ(index[0].parent, IntrospectionIndex::npos);
+  EXPECT_EQ(index[0].subtree_end, 6);
+  EXPECT_EQ(index[0].element.container_stats->length, 2);
+
+  auto outer = index.children(0);
+  ASSERT_EQ(outer.size(), 2);
+  EXPECT_EQ(outer[0], 1);
+  EXPECT_EQ(outer[1], 3);
+
+  EXPECT_EQ(index[1].subtree_end, 3);
+  EXPECT_EQ(index.children(1).size(), 1);
+  EXPECT_EQ(index[2].parent, 1);
+  EXPECT_TRUE(index.children(2).empty());
+
+  ASSERT_EQ(index.children(3).size(), 2);
+  EXPECT_EQ(index.children(3)[1], 5);
+  EXPECT_EQ(index[5].parent, 3);
+  EXPECT_TRUE(pathIs(index.typePath(5), {"v", "[]", "[]"}));
+}
+
+TEST(IntrospectionIndexTest, SizesAndDataOffsets) {
+  IntrospectionResult result{std::vector<uint8_t>{2, 1, 2}, nestedVector};
+  IntrospectionIndex index{result};
+
+  EXPECT_EQ(index[2].inclusive_size, sizeof(int));
+  EXPECT_EQ(index[3].inclusive_size, 24 + 2 * sizeof(int));
+  EXPECT_EQ(index[0].inclusive_size, 3 * 24 + 3 * sizeof(int));
+
+  // Each vector reads its length, the ints read nothing
+  EXPECT_EQ(index[0].data_offset, 0);
+  EXPECT_EQ(index[1].data_offset, 1);
+  EXPECT_EQ(index[2].data_offset, 2);
+  EXPECT_EQ(index[3].data_offset, 2);
+  EXPECT_EQ(index[5].data_offset, 3);
+}
+
+TEST(IntrospectionIndexTest, Largest) {
+  // Vectors of 1, 3 and 2 ints
+  IntrospectionResult result{std::vector<uint8_t>{3, 1, 3, 2}, nestedVector};
+  IntrospectionIndex index{result};
+
+  auto outer = index.children(0);
+  EXPECT_EQ(index.largestChildren(0, 2),
+            (std::vector<IntrospectionIndex::NodeID>{outer[1], outer[2]}));
+  EXPECT_EQ(index.largestChildren(0, 10).size(), 3);
+  EXPECT_TRUE(index.largestChildren(0, 0).empty());
+
+  // The inner vectors are larger than the ints
+  EXPECT_EQ(index.largestDescendants(0, 3).size(), 3);
+  for (auto id : index.largestDescendants(0, 3))
+    EXPECT_EQ(index[id].element.type_names[0], "std::vector<int>");
+  EXPECT_EQ(index.largestDescendants(outer[1], 5).size(), 3);
+}
+
+TEST(IntrospectionIndexTest, AggregatedElements) {
+  IntrospectionResult result{std::vector<uint8_t>{5}, pointVector};
+  result.setAggregateElements(true);
+  IntrospectionIndex index{result};
+
+  ASSERT_EQ(index.size(), 2);
+  EXPECT_EQ(index[1].element.aggregate_count, 5);
+  EXPECT_EQ(index[0].inclusive_size, 24 + 5 * 2 * sizeof(int));
+}
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "oi/LruCache.h"
+
+using namespace oi::detail;
+
+TEST(LruCacheTest, GetMissingEntry) {
+  LruCache<std::string, int> cache{2};
+  EXPECT_EQ(cache.get("a"), nullptr);
+  EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(LruCacheTest, EvictsLeastRecentlyUsed) {
+  LruCache<std::string, int> cache{2};
+  cache.put("a", 1);
+  cache.put("b", 2);
+
+  // Touch "a" so that "b" becomes the least recently used entry
+  ASSERT_NE(cache.get("a"), nullptr);
+  cache.put("c", 3);
+
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.get("b"), nullptr);
+  ASSERT_NE(cache.get("a"), nullptr);
+  EXPECT_EQ(*cache.get("a"), 1);
+  ASSERT_NE(cache.get("c"), nullptr);
+  EXPECT_EQ(*cache.get("c"), 3);
+}
+
+TEST(LruCacheTest, PutReplacesExistingEntry) {
+  LruCache<std::string, int> cache{2};
+  cache.put("a", 1);
+  cache.put("b", 2);
+  cache.put("a", 10);
+  cache.put("c", 3);
+
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.get("b"), nullptr);
+  ASSERT_NE(cache.get("a"), nullptr);
+  EXPECT_EQ(*cache.get("a"), 10);
+}
+
+TEST(LruCacheTest, EvictOldest) {
+  LruCache<std::string, int> cache{4};
+  cache.put("a", 1);
+  cache.put("b", 2);
+
+  EXPECT_TRUE(cache.evictOldest());
+  EXPECT_EQ(cache.get("a"), nullptr);
+  EXPECT_TRUE(cache.evictOldest());
+  EXPECT_FALSE(cache.evictOldest());
+  EXPECT_EQ(cache.size(), 0);
+}
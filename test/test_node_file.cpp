@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include "oi/NodeFile.h"
+
+using namespace oi::detail::nodefile;
+
+namespace fs = std::filesystem;
+
+class NodeFileTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    tmpdir = fs::temp_directory_path() / "test-XXXXXX";
+    ASSERT_NE(mkdtemp(const_cast<char*>(tmpdir.c_str())), nullptr);
+    path = tmpdir / "nodes.oin";
+  }
+
+  void TearDown() override {
+    fs::remove_all(tmpdir);
+  }
+
+  fs::path tmpdir;
+  fs::path path;
+};
+
+TEST_F(NodeFileTest, RoundTrip) {
+  std::vector<NodeID> rootIDs{10};
+  {
+    NodeFileWriter writer{path, 10};
+
+    // Children are written before their parent, as TreeBuilder does
+    NodeRecord child{};
+    child.id = 11;
+    child.name = writer.addString("x");
+    child.typeName = writer.addString("int");
+    child.staticSize = 4;
+    child.exclusiveSize = 4;
+    writer.write(child);
+
+    NodeRecord root{};
+    root.id = 10;
+    root.name = writer.addString("v");
+    root.typeName = writer.addString("std::vector<int>");
+    root.typePath = writer.addString("v");
+    root.staticSize = 24;
+    root.dynamicSize = 40;
+    root.exclusiveSize = 64;
+    root.length = 10;
+    root.capacity = 16;
+    root.childrenStart = 11;
+    root.childrenEnd = 12;
+    root.flags = NodeRecord::HasContainerStats | NodeRecord::HasChildren;
+    writer.write(root);
+
+    // Written records can be read back before finishing
+    EXPECT_EQ(writer.read(11).staticSize, 4);
+    EXPECT_EQ(writer.getString(writer.read(10).typeName), "std::vector<int>");
+
+    writer.finish(3, rootIDs);
+  }
+
+  ASSERT_TRUE(NodeFileReader::isNodeFile(path));
+  NodeFileReader reader{path};
+
+  EXPECT_EQ(reader.header().version, 3);
+  EXPECT_EQ(reader.header().firstNodeID, 10);
+  EXPECT_EQ(reader.header().nodeCount, 2);
+  ASSERT_EQ(reader.rootIDs().size(), 1);
+  EXPECT_EQ(reader.rootIDs()[0], 10);
+
+  const auto* root = reader.node(10);
+  ASSERT_NE(root, nullptr);
+  EXPECT_EQ(reader.getString(root->name), "v");
+  EXPECT_EQ(reader.getString(root->typeName), "std::vector<int>");
+  EXPECT_EQ(reader.getString(root->typePath), "v");
+  EXPECT_EQ(root->staticSize, 24);
+  EXPECT_EQ(root->dynamicSize, 40);
+  EXPECT_EQ(root->exclusiveSize, 64);
+  EXPECT_TRUE(root->has(NodeRecord::HasContainerStats));
+  EXPECT_EQ(root->length, 10);
+  EXPECT_EQ(root->capacity, 16);
+  EXPECT_TRUE(root->has(NodeRecord::HasChildren));
+  EXPECT_EQ(root->childrenStart, 11);
+  EXPECT_EQ(root->childrenEnd, 12);
+  EXPECT_FALSE(root->has(NodeRecord::HasPointer));
+
+  const auto* child = reader.node(11);
+  ASSERT_NE(child, nullptr);
+  EXPECT_EQ(reader.getString(child->name), "x");
+  EXPECT_EQ(reader.getString(child->typeName), "int");
+  EXPECT_EQ(reader.getString(child->typePath), "");
+  EXPECT_EQ(child->staticSize, 4);
+
+  EXPECT_EQ(reader.node(9), nullptr);
+  EXPECT_EQ(reader.node(12), nullptr);
+}
+
+TEST_F(NodeFileTest, StringsAreInterned) {
+  NodeFileWriter writer{path, 0};
+  auto a = writer.addString("int");
+  auto b = writer.addString("int");
+  EXPECT_EQ(a.offset, b.offset);
+  EXPECT_EQ(a.size, b.size);
+  EXPECT_NE(writer.addString("long").offset, a.offset);
+}
+
+TEST_F(NodeFileTest, UnwrittenNodesAreMissing) {
+  {
+    NodeFileWriter writer{path, 0};
+    NodeRecord record{};
+    record.id = 2;
+    writer.write(record);
+    EXPECT_THROW(writer.read(1), std::runtime_error);
+    writer.finish(3, {});
+  }
+
+  NodeFileReader reader{path};
+  EXPECT_EQ(reader.header().nodeCount, 3);
+  EXPECT_EQ(reader.node(0), nullptr);
+  EXPECT_EQ(reader.node(1), nullptr);
+  EXPECT_NE(reader.node(2), nullptr);
+  EXPECT_TRUE(reader.rootIDs().empty());
+}
+
+TEST_F(NodeFileTest, RejectsOtherFiles) {
+  std::ofstream{path} << "not a node file, but long enough to hold a header "
+                         "if it were one.";
+  EXPECT_FALSE(NodeFileReader::isNodeFile(path));
+  EXPECT_THROW(NodeFileReader{path}, std::runtime_error);
+}
+
+TEST_F(NodeFileTest, RejectsTruncatedFiles) {
+  {
+    NodeFileWriter writer{path, 0};
+    NodeRecord record{};
+    writer.write(record);
+    writer.finish(3, {});
+  }
+  fs::resize_file(path, sizeof(NodeFileHeader) + 1);
+
+  EXPECT_TRUE(NodeFileReader::isNodeFile(path));
+  EXPECT_THROW(NodeFileReader{path}, std::runtime_error);
+}
@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <oi/oi-jit.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace std::chrono_literals;
+
+namespace {
+
+/*
+ * Each test needs its own type, as the compiled function is cached per
+ * CodegenHandler instantiation.
+ */
+template <int N>
+struct Object {
+  std::vector<int> ints;
+};
+
+template <int N>
+Object<N> makeObject() {
+  return Object<N>{.ints = std::vector<int>(100, N)};
+}
+
+oi::GeneratorOptions makeOptions() {
+  return oi::GeneratorOptions{.configFilePath = CONFIG_FILE_PATH};
+}
+
+// Observes the function swapped in by tier-up
+template <typename T>
+struct TieredHandler : oi::CodegenHandler<T> {
+  using oi::CodegenHandler<T>::getIntrospectionFunc;
+};
+
+size_t countElements(const oi::IntrospectionResult& res) {
+  size_t count = 0;
+  for (auto it = res.begin(); it != res.end(); ++it)
+    count++;
+  return count;
+}
+
+size_t countEntries(const fs::path& registry) {
+  size_t count = 0;
+  for (const auto& entry : fs::directory_iterator{registry})
+    count += entry.path().extension() == ".sym";
+  return count;
+}
+
+}  // namespace
+
+class OilJitTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    tmpdir = fs::temp_directory_path() / "test-XXXXXX";
+    ASSERT_NE(mkdtemp(const_cast<char*>(tmpdir.c_str())), nullptr);
+  }
+
+  void TearDown() override {
+    fs::remove_all(tmpdir);
+  }
+
+  fs::path tmpdir;
+};
+
+// Death tests run first, while the process has no background threads
+using OilJitDeathTest = OilJitTest;
+
+TEST_F(OilJitDeathTest, RegistryHitOnSecondInit) {
+  using Handler = oi::CodegenHandler<Object<0>>;
+
+  auto opts = makeOptions();
+  opts.registryPath = tmpdir / "registry";
+  opts.sourceFileDumpPath = tmpdir / "oil_jit.cpp";
+
+  // An earlier run of this binary, which compiles and fills the registry
+  EXPECT_EXIT(std::exit(Handler::init(opts) ? EXIT_SUCCESS : EXIT_FAILURE),
+              ::testing::ExitedWithCode(EXIT_SUCCESS), "");
+  ASSERT_TRUE(fs::exists(opts.sourceFileDumpPath));
+  ASSERT_EQ(countEntries(opts.registryPath), 1);
+
+  // Code is only generated, and dumped, on a registry miss
+  fs::remove(opts.sourceFileDumpPath);
+  ASSERT_TRUE(Handler::init(opts));
+  EXPECT_FALSE(fs::exists(opts.sourceFileDumpPath));
+  EXPECT_EQ(countEntries(opts.registryPath), 1);
+
+  auto res = Handler::introspect(makeObject<0>());
+  EXPECT_NE(res.begin(), res.end());
+}
+
+TEST_F(OilJitTest, InitAsyncSucceeds) {
+  using Handler = oi::CodegenHandler<Object<1>>;
+  auto obj = makeObject<1>();
+
+  auto future = Handler::initAsync(makeOptions());
+  ASSERT_TRUE(future.get());
+  EXPECT_TRUE(Handler::tryIntrospect(obj).has_value());
+
+  // Later calls return the same future
+  EXPECT_TRUE(Handler::initAsync(makeOptions()).get());
+}
+
+TEST_F(OilJitTest, InitAsyncAfterFailedInit) {
+  using Handler = oi::CodegenHandler<Object<2>>;
+
+  auto opts = makeOptions();
+  opts.configFilePath = tmpdir / "missing.oid.toml";
+  EXPECT_ANY_THROW(Handler::init(opts));
+
+  EXPECT_FALSE(Handler::initAsync(makeOptions()).get());
+  EXPECT_FALSE(Handler::tryIntrospect(makeObject<2>()).has_value());
+}
+
+TEST_F(OilJitTest, InitAsyncFailure) {
+  using Handler = oi::CodegenHandler<Object<3>>;
+
+  auto opts = makeOptions();
+  opts.optimizationLevel = 7;
+  auto future = Handler::initAsync(opts);
+  EXPECT_THROW(future.get(), std::invalid_argument);
+
+  EXPECT_FALSE(Handler::tryIntrospect(makeObject<3>()).has_value());
+  EXPECT_FALSE(Handler::introspect(makeObject<3>(), 1min).has_value());
+}
+
+TEST_F(OilJitTest, IntrospectWithTimeout) {
+  using Handler = oi::CodegenHandler<Object<4>>;
+  auto obj = makeObject<4>();
+
+  // Returns immediately when initAsync was never started
+  EXPECT_FALSE(Handler::introspect(obj, 1h).has_value());
+  EXPECT_FALSE(Handler::tryIntrospect(obj).has_value());
+
+  // Compiling takes far longer than starting the background thread
+  auto future = Handler::initAsync(makeOptions());
+  EXPECT_FALSE(Handler::introspect(obj, 0s).has_value());
+
+  auto res = Handler::introspect(obj, 5min);
+  ASSERT_TRUE(res.has_value());
+  EXPECT_NE(res->begin(), res->end());
+  EXPECT_TRUE(future.get());
+}
+
+TEST_F(OilJitTest, BorrowedBufferKeepsCapacity) {
+  using Handler = oi::CodegenHandler<Object<5>>;
+  auto obj = makeObject<5>();
+  ASSERT_TRUE(Handler::init(makeOptions()));
+
+  std::vector<uint8_t> buf;
+  auto first = Handler::introspect(obj, buf);
+  ASSERT_FALSE(buf.empty());
+  auto size = buf.size();
+  auto capacity = buf.capacity();
+  const auto* data = buf.data();
+  auto elements = countElements(first);
+
+  auto second = Handler::introspect(obj, buf);
+  EXPECT_EQ(buf.size(), size);
+  EXPECT_EQ(buf.capacity(), capacity);
+  EXPECT_EQ(buf.data(), data);
+  EXPECT_EQ(countElements(second), elements);
+}
+
+TEST_F(OilJitTest, TierUpSwapsFunction) {
+  using Handler = TieredHandler<Object<6>>;
+  auto obj = makeObject<6>();
+
+  auto opts = makeOptions();
+  opts.optimizationLevel = 0;
+  opts.backgroundOptimizationLevel = 3;
+  ASSERT_TRUE(Handler::init(opts));
+
+  auto initial = Handler::getIntrospectionFunc().load();
+  ASSERT_NE(initial, nullptr);
+  std::vector<uint8_t> before;
+  Handler::introspect(obj, before);
+
+  auto deadline = std::chrono::steady_clock::now() + 5min;
+  while (Handler::getIntrospectionFunc().load() == initial &&
+         std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(10ms);
+  EXPECT_NE(Handler::getIntrospectionFunc().load(), initial);
+
+  // Both levels produce the same results
+  std::vector<uint8_t> after;
+  Handler::introspect(obj, after);
+  EXPECT_EQ(after, before);
+}
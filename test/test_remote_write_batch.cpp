@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include <climits>
+#include <cstdint>
+#include <vector>
+
+#include "oi/RemoteWriteBatch.h"
+
+extern "C" {
+#include <unistd.h>
+}
+
+using namespace oi::detail;
+
+/*
+ * process_vm_writev(2) is allowed on our own process, so these tests use the
+ * test process as the "remote" one.
+ */
+
+TEST(RemoteWriteBatchTest, WritesValuesAndBuffers) {
+  uint64_t cookie = 0;
+  int logFile = -1;
+  std::vector<uint8_t> segment(4096, 0);
+  std::vector<uint8_t> source(segment.size());
+  for (size_t i = 0; i < source.size(); i++) {
+    source[i] = static_cast<uint8_t>(i);
+  }
+
+  RemoteWriteBatch batch{getpid()};
+  batch.add(source.data(), (uintptr_t)segment.data(), source.size());
+  batch.addValue(uint64_t{0xdeadbeef}, (uintptr_t)&cookie);
+  batch.addValue(42, (uintptr_t)&logFile);
+
+  EXPECT_EQ(batch.size(), 3);
+  EXPECT_EQ(batch.bytes(), source.size() + sizeof(cookie) + sizeof(logFile));
+
+  ASSERT_TRUE(batch.flush());
+  EXPECT_EQ(segment, source);
+  EXPECT_EQ(cookie, 0xdeadbeef);
+  EXPECT_EQ(logFile, 42);
+
+  EXPECT_EQ(batch.size(), 0);
+  EXPECT_EQ(batch.bytes(), 0);
+}
+
+TEST(RemoteWriteBatchTest, SplitsAtIovMax) {
+  size_t count = 2 * IOV_MAX + 3;
+  std::vector<uint64_t> remote(count, 0);
+
+  RemoteWriteBatch batch{getpid()};
+  for (size_t i = 0; i < count; i++) {
+    batch.addValue(uint64_t{i + 1}, (uintptr_t)&remote[i]);
+  }
+
+  ASSERT_TRUE(batch.flush());
+  for (size_t i = 0; i < count; i++) {
+    EXPECT_EQ(remote[i], i + 1);
+  }
+}
+
+TEST(RemoteWriteBatchTest, FailsOnInvalidAddress) {
+  uint64_t value = 1;
+
+  RemoteWriteBatch batch{getpid()};
+  batch.addValue(value, 0);
+
+  EXPECT_FALSE(batch.flush());
+  EXPECT_EQ(batch.size(), 0);
+}
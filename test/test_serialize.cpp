@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+#include "oi/Descs.h"
+#include "oi/PaddingHunter.h"
+#include "oi/Serialize.h"
+
+using namespace oi::detail;
+
+template <typename T>
+static std::string store(const std::string& buildID, const T& data) {
+  std::ostringstream oss{std::ios_base::binary};
+  writeCacheFileHeader(oss);
+  CacheOArchive oa{oss};
+  oa << buildID;
+  oa << data;
+  return oss.str();
+}
+
+template <typename T>
+static std::string load(const std::string& archive, T& data) {
+  std::istringstream iss{archive, std::ios_base::binary};
+  readCacheFileHeader(iss);
+  CacheIArchive ia{iss};
+  std::string buildID;
+  ia >> buildID;
+  ia >> data;
+  return buildID;
+}
+
+TEST(SerializeTest, PaddingInfoRoundTrip) {
+  std::map<std::string, PaddingInfo> paddingInfos;
+  for (size_t i = 0; i < 1000; i++) {
+    paddingInfos.emplace("Struct" + std::to_string(i),
+                         PaddingInfo{i * 8, static_cast<int>(i % 8), i % 16,
+                                     0, "struct Struct" + std::to_string(i),
+                                     i});
+  }
+
+  auto archive = store("build-id", paddingInfos);
+
+  std::map<std::string, PaddingInfo> loaded;
+  EXPECT_EQ(load(archive, loaded), "build-id");
+  ASSERT_EQ(loaded.size(), paddingInfos.size());
+  for (const auto& [name, info] : paddingInfos) {
+    const auto& other = loaded.at(name);
+    EXPECT_EQ(other.structSize, info.structSize);
+    EXPECT_EQ(other.savingSize, info.savingSize);
+    EXPECT_EQ(other.paddingSize, info.paddingSize);
+    EXPECT_EQ(other.definition, info.definition);
+    EXPECT_EQ(other.instancesCnt, info.instancesCnt);
+  }
+}
+
+TEST(SerializeTest, GlobalDescsRoundTrip) {
+  std::unordered_map<std::string, std::shared_ptr<GlobalDesc>> globalDescs;
+  for (uintptr_t i = 0; i < 100; i++) {
+    auto name = "global" + std::to_string(i);
+    auto gd = std::make_shared<GlobalDesc>(name, 0x1000 + i * 8);
+    gd->typeName = "int";
+    globalDescs.emplace(name, std::move(gd));
+  }
+
+  auto archive = store("build-id", globalDescs);
+
+  std::unordered_map<std::string, std::shared_ptr<GlobalDesc>> loaded;
+  load(archive, loaded);
+  ASSERT_EQ(loaded.size(), globalDescs.size());
+  for (const auto& [name, gd] : globalDescs) {
+    const auto& other = loaded.at(name);
+    EXPECT_EQ(other->symName, gd->symName);
+    EXPECT_EQ(other->typeName, gd->typeName);
+    EXPECT_EQ(other->baseAddr, gd->baseAddr);
+  }
+}
+
+TEST(SerializeTest, RejectsUnknownFormat) {
+  std::map<std::string, PaddingInfo> data;
+
+  { /* Files without a header, e.g. the former text archives */
+    EXPECT_THROW(load("22 serialization::archive 19 8 build-id", data),
+                 std::runtime_error);
+  }
+
+  { /* Files from another format version */
+    auto archive = store("build-id", data);
+    CacheFileHeader header{cacheFileMagic, cacheFileFormatVersion + 1};
+    archive.replace(0, sizeof(header),
+                    reinterpret_cast<const char*>(&header), sizeof(header));
+    EXPECT_THROW(load(archive, data), std::runtime_error);
+  }
+}
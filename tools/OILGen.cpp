@@ -37,11 +37,13 @@ constexpr static OIOpts opts{
     OIOpt{'d', "debug-level", required_argument, "<level>",
           "Verbose level for logging"},
     OIOpt{'j', "dump-jit", optional_argument, "<jit.cpp>",
-          "Write generated code to a file (for debugging)."},
+          "Write generated code to files, one per type (for debugging)."},
     OIOpt{'e', "exit-code", no_argument, nullptr,
           "Return a bad exit code if nothing is generated."},
     OIOpt{'p', "pic", no_argument, nullptr,
           "Generate position independent code."},
+    OIOpt{'J', "jobs", required_argument, "<N>",
+          "Compile up to N types concurrently (default: 1)."},
 };
 
 void usage() {
@@ -65,6 +67,7 @@ int main(int argc, char* argv[]) {
   fs::path sourceFileDumpPath = "";
   bool exitCode = false;
   bool pic = false;
+  size_t jobs = 1;
 
   int c;
   while ((c = getopt_long(argc, argv, opts.shortOpts(), opts.longOpts(),
@@ -96,6 +99,9 @@ int main(int argc, char* argv[]) {
       case 'p':
         pic = true;
         break;
+      case 'J':
+        jobs = std::strtoul(optarg, nullptr, 10);
+        break;
     }
   }
 
@@ -118,6 +124,7 @@ int main(int argc, char* argv[]) {
   oigen.setSourceFileDumpPath(sourceFileDumpPath);
   oigen.setFailIfNothingGenerated(exitCode);
   oigen.setUsePIC(pic);
+  oigen.setJobs(jobs);
 
   SymbolService symbols(primaryObject);
 
@@ -13,7 +13,6 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
-#include <boost/archive/text_iarchive.hpp>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
@@ -319,8 +318,9 @@ int main(int argc, char* argv[]) {
     fprintf(stderr, "File not found: %s\n", cachePath.c_str());
     return EXIT_FAILURE;
   }
-  std::ifstream cacheFile{cachePath};
-  boost::archive::text_iarchive cacheArchive{cacheFile};
+  std::ifstream cacheFile{cachePath, std::ios_base::binary};
+  oi::detail::readCacheFileHeader(cacheFile);
+  oi::detail::CacheIArchive cacheArchive{cacheFile};
 
   std::string buildID;
   cacheArchive >> buildID;
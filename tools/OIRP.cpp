@@ -13,6 +13,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <array>
 #include <cassert>
 #include <cstdio>
 #include <cstring>
@@ -24,10 +25,14 @@
 #include <span>
 #include <vector>
 
+#include "oi/NodeFile.h"
 #include "rocksdb/db.h"
 #include "rocksdb/options.h"
 #include "rocksdb/statistics.h"
 
+using oi::detail::nodefile::NodeFileReader;
+using oi::detail::nodefile::NodeRecord;
+
 using Version = uint64_t;
 using NodeID = uint64_t;
 
@@ -137,6 +142,12 @@ struct Node {
    */
   size_t exclusiveSize{};
 
+  /**
+   * Number of container elements a summary node stands for, when the
+   * elements were aggregated.
+   */
+  std::optional<size_t> aggregateCount{std::nullopt};
+
   MSGPACK_DEFINE_ARRAY(id,
                        name,
                        typeName,
@@ -149,7 +160,8 @@ struct Node {
                        pointer,
                        children,
                        isset,
-                       exclusiveSize)
+                       exclusiveSize,
+                       aggregateCount)
 };
 
 std::ostream& operator<<(std::ostream& os, const Node& node) {
@@ -191,12 +203,107 @@ std::ostream& operator<<(std::ostream& os, const Node& node) {
     os << "  Is set not available\n";
   }
   os << "  Exclusive size: " << node.exclusiveSize << "\n";
+  if (node.aggregateCount.has_value()) {
+    os << "  Aggregate count: " << *node.aggregateCount << "\n";
+  }
   return os;
 }
 
+/*
+ * Since version 3 of the database, nodes are keyed by their ID as a
+ * fixed-width, big-endian integer. See TreeBuilder.h for more info.
+ */
+static std::array<char, sizeof(NodeID)> nodeKey(NodeID id) {
+  std::array<char, sizeof(NodeID)> key{};
+  for (size_t i = 0; i < key.size(); i++) {
+    key[i] = static_cast<char>(id >> (8 * (key.size() - 1 - i)));
+  }
+  return key;
+}
+
+/*
+ * Parse the ranges into two integers; start and end.
+ * If the range contains a single integer, that integer becomes the whole
+ * range.
+ */
+static std::pair<NodeID, NodeID> parseRange(const char* range) {
+  NodeID start = 0, end = 0;
+  if (const char* dash = std::strchr(range, '-')) {
+    start = std::strtoul(range, nullptr, 10);
+    end = std::strtoul(dash + 1, nullptr, 10);
+  } else {
+    start = std::strtoul(range, nullptr, 10);
+    end = start;
+  }
+  return {start, end};
+}
+
+static Node nodeFromRecord(const NodeFileReader& reader,
+                           const NodeRecord& record) {
+  Node node{
+      .id = record.id,
+      .name = reader.getString(record.name),
+      .typeName = std::string{reader.getString(record.typeName)},
+      .typePath = std::string{reader.getString(record.typePath)},
+      .isTypedef = record.has(NodeRecord::IsTypedef),
+      .staticSize = record.staticSize,
+      .dynamicSize = record.dynamicSize,
+      .exclusiveSize = record.exclusiveSize,
+  };
+  if (record.has(NodeRecord::HasPaddingSavingsSize))
+    node.paddingSavingsSize = record.paddingSavingsSize;
+  if (record.has(NodeRecord::HasPointer))
+    node.pointer = record.pointer;
+  if (record.has(NodeRecord::HasContainerStats))
+    node.containerStats = Node::ContainerStats{
+        record.length, record.capacity, record.elementStaticSize};
+  if (record.has(NodeRecord::HasChildren))
+    node.children = {record.childrenStart, record.childrenEnd};
+  if (record.has(NodeRecord::HasIsset))
+    node.isset = record.has(NodeRecord::Isset);
+  if (record.has(NodeRecord::HasAggregateCount))
+    node.aggregateCount = record.aggregateCount;
+  return node;
+}
+
+static int printNodeFile(const std::filesystem::path& path,
+                         std::span<const char*> ranges) {
+  std::optional<NodeFileReader> reader;
+  try {
+    reader.emplace(path);
+  } catch (const std::exception& e) {
+    fprintf(stderr, "Failed to open node file '%s' with error %s\n",
+            path.string().c_str(), e.what());
+    return 1;
+  }
+
+  for (const auto& range : ranges) {
+    auto [start, end] = parseRange(range);
+
+    for (NodeID id = start; id <= end; id++) {
+      if (id == ROOT_NODE_ID) {
+        const auto rootIDs = reader->rootIDs();
+        DBHeader header{
+            .version = reader->header().version,
+            .rootIDs = {rootIDs.begin(), rootIDs.end()},
+        };
+        std::cout << header << "\n";
+      } else if (const auto* record = reader->node(id)) {
+        std::cout << nodeFromRecord(*reader, *record) << "\n";
+      } else {
+        continue;
+      }
+
+      std::cout << std::endl;
+    }
+  }
+
+  return 0;
+}
+
 int main(int argc, const char** argv) {
   if (argc < 3) {
-    fprintf(stderr, "usage: %s <db_dir> <ranges>...\n", argv[0]);
+    fprintf(stderr, "usage: %s <db_dir|node_file> <ranges>...\n", argv[0]);
     fprintf(stderr, "  where <ranges> are a single number\n");
     fprintf(stderr, "  or a '-' separated span of indexes\n");
     return 1;
@@ -206,9 +313,14 @@ int main(int argc, const char** argv) {
   std::span<const char*> ranges{&argv[2], &argv[argc]};
 
   assert(std::filesystem::exists(dbpath));
-  assert(std::filesystem::is_directory(dbpath));
   assert(ranges.size() > 0);
 
+  if (NodeFileReader::isNodeFile(dbpath)) {
+    return printNodeFile(dbpath, ranges);
+  }
+
+  assert(std::filesystem::is_directory(dbpath));
+
   // Open the database...
   rocksdb::Options options{};
   options.compression = rocksdb::kZSTD;
@@ -234,27 +346,27 @@ int main(int argc, const char** argv) {
     db.reset(_db);
   }
 
+  // Databases from before version 3 have decimal keys, they are recognised by
+  // their header not being found under the fixed-width key
+  auto getNode = [&db](NodeID id, std::string& data, bool decimalKeys) {
+    if (decimalKeys) {
+      return db->Get(rocksdb::ReadOptions(), std::to_string(id), &data);
+    }
+    auto key = nodeKey(id);
+    return db->Get(rocksdb::ReadOptions(),
+                   rocksdb::Slice{key.data(), key.size()}, &data);
+  };
+  std::string header;
+  bool decimalKeys = !getNode(ROOT_NODE_ID, header, false).ok();
+
   // Iterate over the given ranges...
   for (const auto& range : ranges) {
-    NodeID start = 0, end = 0;
-
-    // Parse the range into two integers; start and end.
-    // If the range contains a single integer, that integer becomes the whole
-    // range.
-    if (const char* dash = std::strchr(range, '-')) {
-      start = std::strtoul(range, nullptr, 10);
-      end = std::strtoul(dash + 1, nullptr, 10);
-    } else {
-      start = std::strtoul(range, nullptr, 10);
-      end = start;
-    }
+    auto [start, end] = parseRange(range);
 
     // Print the contents of the nodes...
     for (NodeID id = start; id <= end; id++) {
       std::string data;
-      if (auto status =
-              db->Get(rocksdb::ReadOptions(), std::to_string(id), &data);
-          !status.ok()) {
+      if (auto status = getNode(id, data, decimalKeys); !status.ok()) {
         continue;
       }
 
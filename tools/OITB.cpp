@@ -15,7 +15,7 @@
  */
 #include <glog/logging.h>
 
-#include <boost/archive/text_iarchive.hpp>
+#include <chrono>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
@@ -42,6 +42,15 @@ constexpr static OIOpts opts{
     OIOpt{'J', "dump-json", optional_argument, "[oid_out.json]",
           "File to dump the results to, as JSON\n"
           "(in addition to the default RocksDB output)"},
+    OIOpt{'n', "node-file", required_argument, "<path>",
+          "Write the results to a columnar node file at <path>\n"
+          "(instead of the default RocksDB output)"},
+    OIOpt{'A', "aggregate-elements", no_argument, nullptr,
+          "Summarise the elements of containers which have no dynamic size\n"
+          "as a single node per element type, instead of a node per element"},
+    OIOpt{'r', "repeat", required_argument, "<count>",
+          "Run TreeBuilder <count> times over the dump and report the time\n"
+          "taken per run. TreeBuilder's logging is disabled for accuracy"},
     OIOpt{'f', "enable-feature", required_argument, "FEATURE",
           "Enable feature"},
     OIOpt{'F', "disable-feature", required_argument, "FEATURE",
@@ -79,16 +88,18 @@ static auto loadTypeInfo(fs::path thPath, fs::path pdPath) {
   std::map<std::string, PaddingInfo> pd;
 
   { /* Load TypeHierarchy */
-    std::ifstream ifs(thPath);
-    boost::archive::text_iarchive ia(ifs);
+    std::ifstream ifs(thPath, std::ios_base::binary);
+    readCacheFileHeader(ifs);
+    CacheIArchive ia(ifs);
 
     ia >> cacheBuildId;
     ia >> th;
   }
 
   { /* Load PaddingInfo */
-    std::ifstream ifs(pdPath);
-    boost::archive::text_iarchive ia(ifs);
+    std::ifstream ifs(pdPath, std::ios_base::binary);
+    readCacheFileHeader(ifs);
+    CacheIArchive ia(ifs);
 
     ia >> cacheBuildId;
     ia >> pd;
@@ -127,6 +138,10 @@ operator<<(std::ostream& out, TreeBuilder::Config tbc) {
   out << "\n  genPaddingStats = " << tbc.features[Feature::GenPaddingStats];
   out << "\n  dumpDataSegment = " << tbc.dumpDataSegment;
   out << "\n  jsonPath = " << (tbc.jsonPath ? *tbc.jsonPath : "NONE");
+  out << "\n  nodeFilePath = "
+      << (tbc.nodeFilePath ? *tbc.nodeFilePath : "NONE");
+  out << "\n  dbPath = " << (tbc.dbPath ? *tbc.dbPath : "NONE");
+  out << "\n  aggregateElements = " << tbc.aggregateElements;
   out << "\n]\n";
   return out;
 }
@@ -143,7 +158,11 @@ int main(int argc, char* argv[]) {
       .logAllStructs = true,
       .dumpDataSegment = false,
       .jsonPath = std::nullopt,
+      .nodeFilePath = std::nullopt,
+      .dbPath = std::nullopt,
+      .aggregateElements = false,
   };
+  long repeat = 0;
 
   int c = '\0';
   while ((c = getopt_long(argc, argv, opts.shortOpts(), opts.longOpts(),
@@ -169,6 +188,19 @@ int main(int argc, char* argv[]) {
       case 'J':
         tbConfig.jsonPath = optarg ? optarg : "oid_out.json";
         break;
+      case 'n':
+        tbConfig.nodeFilePath = optarg;
+        break;
+      case 'A':
+        tbConfig.aggregateElements = true;
+        break;
+      case 'r': {
+        char* end = nullptr;
+        repeat = strtol(optarg, &end, 10);
+        if (*optarg == '\0' || *end != '\0' || repeat <= 0)
+          fatal_error("Invalid repeat count specified: ", optarg);
+        break;
+      }
 
       case ':':
         fatal_error("missing option argument");
@@ -198,8 +230,27 @@ int main(int argc, char* argv[]) {
     typeTree.setPaddedStructs(&paddingInfos);
   }
 
-  LOG(INFO) << "Running TreeBuilder...";
-  typeTree.build(dataseg, rootType.varName, rootType.type.type, typeHierarchy);
+  if (repeat > 0) {
+    google::SetVLOGLevel("TreeBuilder", 0);
+    LOG(INFO) << "Running TreeBuilder " << repeat << " times...";
+
+    using clock = std::chrono::steady_clock;
+    clock::duration total{};
+    for (long i = 0; i < repeat; i++) {
+      auto start = clock::now();
+      typeTree.build(dataseg, rootType.varName, rootType.type.type,
+                     typeHierarchy);
+      total += clock::now() - start;
+    }
+
+    std::chrono::duration<double, std::milli> perRun = total / repeat;
+    std::cout << "TreeBuilder took " << perRun.count() << " ms per run ("
+              << repeat << " runs)" << std::endl;
+  } else {
+    LOG(INFO) << "Running TreeBuilder...";
+    typeTree.build(dataseg, rootType.varName, rootType.type.type,
+                   typeHierarchy);
+  }
 
   if (tbConfig.jsonPath) {
     LOG(INFO) << "Writting JSON results to " << *tbConfig.jsonPath << "...";